@@ -0,0 +1,199 @@
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+
+#include "pancake/core/entity.hpp"
+#include "pancake/physics/world.hpp"
+#include "pancake/physics/force.hpp"
+#include "pancake/physics/collision.hpp"
+#include "pancake/physics/collider.hpp"
+#include "pancake/physics/rigidbody.hpp"
+
+using namespace Pancake;
+
+namespace {
+
+    const int BODIES = 20000;
+    const int WARMUP = 60;
+    const int STEPS = 120;
+    const float TIME_STEP = 1.0f / 60.0f;
+    const float WIDTH = 200.0f;
+    const int CHECKED_PAIRS = 20000;
+    const float TOLERANCE = 0.0001f;
+
+    double milliseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    template<class C>
+    C* attach(C* collider, glm::vec2 position, float rotation) {
+        Entity* entity = new Entity(position.x, position.y);
+        entity->setRotation(rotation);
+        Rigidbody* rigidbody = new Rigidbody();
+        rigidbody->addCollider(collider);
+        entity->addComponent(rigidbody);
+        return collider;
+    }
+
+    bool close(float a, float b) {
+        return std::abs(a - b) <= TOLERANCE * std::max(1.0f, std::abs(a));
+    }
+
+    bool same(const CollisionManifold& a, const CollisionManifold& b) {
+        return close(a.normal.x, b.normal.x) && close(a.normal.y, b.normal.y)
+            && close(a.point.x, b.point.x) && close(a.point.y, b.point.y)
+            && close(a.depth, b.depth);
+    }
+
+    // Checks the batched circle tests give the same manifolds as the single pair tests, for random pairs of
+    // circles and of rotated circles and boxes in either order. Returns how many pairs differ.
+    int check() {
+
+        std::mt19937 random(54321);
+        std::uniform_real_distribution<float> position(-2.0f, 2.0f);
+        std::uniform_real_distribution<float> size(0.1f, 1.5f);
+        std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+        std::uniform_int_distribution<int> coin(0, 1);
+
+        // Colliders are not deleted, entities can only be destroyed with a scene.
+        CirclePairs circles;
+        CircleBoxPairs circleBoxes;
+        std::vector<std::pair<Collider*, Collider*>> circlePairs;
+        std::vector<std::pair<Collider*, Collider*>> circleBoxPairs;
+
+        for (int i = 0; i < CHECKED_PAIRS; i++) {
+
+            CircleCollider* a = attach(new CircleCollider(), glm::vec2(position(random), position(random)), 0.0f);
+            CircleCollider* b = attach(new CircleCollider(), glm::vec2(position(random), position(random)), 0.0f);
+            a->setRadius(size(random));
+            b->setRadius(size(random));
+            circles.add(a, b);
+            circlePairs.push_back(std::make_pair(a, b));
+
+            // Every other box is left unrotated, since that skips the rotation in both tests.
+            CircleCollider* c = attach(new CircleCollider(), glm::vec2(position(random), position(random)), 0.0f);
+            BoxCollider* box = attach(new BoxCollider(), glm::vec2(position(random), position(random)), i % 2 == 0 ? angle(random) : 0.0f);
+            c->setRadius(size(random));
+            box->setSize(glm::vec2(2.0f * size(random), 2.0f * size(random)));
+            bool flip = coin(random) == 1;
+            circleBoxes.add(c, box, flip);
+            circleBoxPairs.push_back(flip ? std::make_pair((Collider*) box, (Collider*) c) : std::make_pair((Collider*) c, (Collider*) box));
+
+        }
+
+        std::vector<CollisionManifold> manifolds(CHECKED_PAIRS);
+        std::vector<unsigned char> hits(CHECKED_PAIRS);
+        CollisionManifold expected[Collision::MAX_MANIFOLDS];
+        int mismatches = 0;
+
+        Collision::findCollisionFeatures(circles, manifolds.data(), hits.data());
+        for (int i = 0; i < CHECKED_PAIRS; i++) {
+            int count = Collision::findCollisionFeatures(circlePairs[i].first, circlePairs[i].second, expected);
+            if ((count > 0) != (hits[i] != 0) || (count > 0 && !same(expected[0], manifolds[i]))) {mismatches++;}
+        }
+
+        Collision::findCollisionFeatures(circleBoxes, manifolds.data(), hits.data());
+        for (int i = 0; i < CHECKED_PAIRS; i++) {
+            int count = Collision::findCollisionFeatures(circleBoxPairs[i].first, circleBoxPairs[i].second, expected);
+            if ((count > 0) != (hits[i] != 0) || (count > 0 && !same(expected[0], manifolds[i]))) {mismatches++;}
+        }
+
+        return mismatches;
+
+    }
+
+    Rigidbody* createStatic(World& world, glm::vec2 position, glm::vec2 size) {
+        Entity* entity = new Entity(position.x, position.y);
+        BoxCollider* collider = new BoxCollider();
+        collider->setSize(size);
+        collider->setMass(0.0f);
+        Rigidbody* rigidbody = new Rigidbody();
+        rigidbody->addCollider(collider);
+        rigidbody->setRestitution(0.0f);
+        entity->addComponent(rigidbody);
+        world.add(rigidbody);
+        return rigidbody;
+    }
+
+    // Drops a pile of circles and boxes into a container and times the steps once the pile is dense.
+    double run(int threads) {
+
+        World world(TIME_STEP, glm::vec2(0.0f, -10.0f));
+        world.setThreadCount(threads);
+
+        Gravity* gravity = new Gravity();
+        gravity->setAcceleration(0.0f, -10.0f);
+        world.addForceGenerator(gravity);
+
+        createStatic(world, glm::vec2(0.0f, -0.5f), glm::vec2(WIDTH, 1.0f));
+        createStatic(world, glm::vec2(-WIDTH * 0.5f, 200.0f), glm::vec2(1.0f, 400.0f));
+        createStatic(world, glm::vec2(WIDTH * 0.5f, 200.0f), glm::vec2(1.0f, 400.0f));
+
+        // Bodies are not deleted, entities can only be destroyed with a scene.
+        std::mt19937 random(12345);
+        std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+        int columns = (int) (WIDTH - 2.0f);
+        for (int i = 0; i < BODIES; i++) {
+
+            Entity* entity = new Entity((i % columns) - (columns * 0.5f) + 1.0f + jitter(random), 1.0f + (i / columns) * 1.1f);
+            Rigidbody* rigidbody = new Rigidbody();
+
+            if (i % 2 == 0) {
+                CircleCollider* collider = new CircleCollider();
+                collider->setRadius(0.5f);
+                collider->setMass(1.0f);
+                rigidbody->addCollider(collider);
+            } else {
+                BoxCollider* collider = new BoxCollider();
+                collider->setSize(glm::vec2(0.9f, 0.9f));
+                collider->setMass(1.0f);
+                rigidbody->addCollider(collider);
+            }
+
+            rigidbody->setRestitution(0.0f);
+            rigidbody->setFriction(0.3f);
+            rigidbody->setSleepingAllowed(false);
+            rigidbody->addForceGenerator("Gravity");
+            entity->addComponent(rigidbody);
+            world.add(rigidbody);
+
+        }
+
+        for (int s = 0; s < WARMUP; s++) {world.update(TIME_STEP);}
+
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < STEPS; s++) {world.update(TIME_STEP);}
+        auto end = std::chrono::steady_clock::now();
+        return milliseconds(start, end) / STEPS;
+
+    }
+
+}
+
+int main() {
+
+    // The timings mean nothing if the batched tests have drifted from the single pair tests.
+    int mismatches = check();
+    std::cout << "batched pairs checked: " << 2 * CHECKED_PAIRS << "  mismatches: " << mismatches << "\n";
+    if (mismatches > 0) {return 1;}
+
+    int hardware = std::max(1, (int) std::thread::hardware_concurrency());
+    double serial = 0.0;
+
+    for (int threads = 1; threads <= hardware; threads *= 2) {
+        double step = run(threads);
+        if (threads == 1) {serial = step;}
+        std::cout << "threads: " << threads
+                  << "  bodies: " << BODIES
+                  << "  step: " << step << " ms"
+                  << "  speedup: " << serial / step << "x\n";
+    }
+
+    return 0;
+
+}
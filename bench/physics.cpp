@@ -0,0 +1,186 @@
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+#include "pancake/core/entity.hpp"
+#include "pancake/physics/world.hpp"
+#include "pancake/physics/force.hpp"
+#include "pancake/physics/collider.hpp"
+#include "pancake/physics/rigidbody.hpp"
+
+using namespace Pancake;
+using json = nlohmann::json;
+
+namespace {
+
+    const int DEFAULT_BODIES = 4000;
+    const int DEFAULT_STEPS = 300;
+    const float TIME_STEP = 1.0f / 60.0f;
+
+    // The rigidbodies are added to the world directly, without a scene, so no window is needed.
+    Rigidbody* create(World& world, glm::vec2 position, Collider* collider, bool dynamic) {
+        Entity* entity = new Entity(position.x, position.y);
+        Rigidbody* rigidbody = new Rigidbody();
+        collider->setMass(dynamic ? 1.0f : 0.0f);
+        rigidbody->addCollider(collider);
+        rigidbody->setRestitution(0.0f);
+        rigidbody->setFriction(0.5f);
+        rigidbody->setSleepingAllowed(false);
+        if (dynamic) {rigidbody->addForceGenerator("Gravity");}
+        entity->addComponent(rigidbody);
+        world.add(rigidbody);
+        return rigidbody;
+    }
+
+    BoxCollider* box(glm::vec2 size) {
+        BoxCollider* collider = new BoxCollider();
+        collider->setSize(size);
+        return collider;
+    }
+
+    CircleCollider* circle(float radius) {
+        CircleCollider* collider = new CircleCollider();
+        collider->setRadius(radius);
+        return collider;
+    }
+
+    // Circles and boxes dropped in rows into a container, which settle into a dense pile.
+    int pile(World& world, int bodies, std::mt19937& random) {
+
+        float width = std::max(20.0f, std::sqrt((float) bodies) * 2.0f);
+        create(world, glm::vec2(0.0f, -0.5f), box(glm::vec2(width, 1.0f)), false);
+        create(world, glm::vec2(-width * 0.5f, width), box(glm::vec2(1.0f, width * 2.0f)), false);
+        create(world, glm::vec2(width * 0.5f, width), box(glm::vec2(1.0f, width * 2.0f)), false);
+
+        std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+        int columns = (int) (width - 2.0f);
+        for (int i = 0; i < bodies; i++) {
+            glm::vec2 position((i % columns) - columns * 0.5f + 1.0f + jitter(random), 1.0f + (i / columns) * 1.1f);
+            if (i % 2 == 0) {create(world, position, circle(0.5f), true);}
+            else {create(world, position, box(glm::vec2(0.9f, 0.9f)), true);}
+        }
+
+        return bodies;
+
+    }
+
+    // Circles and boxes scattered through the sky, falling through a field of pegs onto the ground.
+    int rain(World& world, int bodies, std::mt19937& random) {
+
+        float width = std::max(40.0f, std::sqrt((float) bodies) * 4.0f);
+        create(world, glm::vec2(0.0f, -0.5f), box(glm::vec2(width, 1.0f)), false);
+        for (float x = -width * 0.5f + 2.0f; x < width * 0.5f - 2.0f; x += 4.0f) {
+            for (float y = 4.0f; y < 20.0f; y += 4.0f) {create(world, glm::vec2(x + std::fmod(y, 8.0f) * 0.25f, y), circle(0.5f), false);}
+        }
+
+        std::uniform_real_distribution<float> x(-width * 0.5f + 1.0f, width * 0.5f - 1.0f);
+        std::uniform_real_distribution<float> y(25.0f, 25.0f + bodies * 4.0f / width);
+        std::uniform_real_distribution<float> size(0.2f, 0.6f);
+        for (int i = 0; i < bodies; i++) {
+            glm::vec2 position(x(random), y(random));
+            float s = size(random);
+            Rigidbody* rigidbody = i % 2 == 0 ? create(world, position, circle(s), true) : create(world, position, box(glm::vec2(s * 2.0f, s * 2.0f)), true);
+            rigidbody->setVelocity(0.0f, -10.0f);
+        }
+
+        return bodies;
+
+    }
+
+    // Pyramids of boxes side by side, each as tall as it can be while the total stays near the body count.
+    int pyramid(World& world, int bodies, std::mt19937& random) {
+
+        int rows = std::max(1, std::min(40, (int) std::sqrt((float) bodies)));
+        int perPyramid = rows * (rows + 1) / 2;
+        int pyramids = std::max(1, bodies / perPyramid);
+        float width = pyramids * (rows + 2.0f);
+        create(world, glm::vec2(0.0f, -0.5f), box(glm::vec2(width + 4.0f, 1.0f)), false);
+
+        for (int p = 0; p < pyramids; p++) {
+            float left = -width * 0.5f + p * (rows + 2.0f) + 1.0f;
+            for (int row = 0; row < rows; row++) {
+                for (int i = 0; i < rows - row; i++) {
+                    create(world, glm::vec2(left + row * 0.5f + i + 0.5f, row + 0.5f), box(glm::vec2(1.0f, 1.0f)), true);
+                }
+            }
+        }
+
+        return pyramids * perPyramid;
+
+    }
+
+    // Builds the scene, steps it, and returns the average and worst timings of each phase.
+    json run(std::string scene, int bodies, int steps, int threads) {
+
+        World world(TIME_STEP, glm::vec2(0.0f, -10.0f));
+        world.setThreadCount(threads);
+
+        Gravity* gravity = new Gravity();
+        gravity->setAcceleration(0.0f, -10.0f);
+        world.addForceGenerator(gravity);
+
+        // Bodies are not deleted, entities can only be destroyed with a scene.
+        std::mt19937 random(12345);
+        if (scene == "pile") {bodies = pile(world, bodies, random);}
+        else if (scene == "rain") {bodies = rain(world, bodies, random);}
+        else {bodies = pyramid(world, bodies, random);}
+
+        StepTimings sum;
+        double worst = 0.0;
+        for (int s = 0; s < steps; s++) {
+            world.update(TIME_STEP);
+            StepTimings t = world.getTimings();
+            sum.integrate += t.integrate;
+            sum.broadphase += t.broadphase;
+            sum.narrowphase += t.narrowphase;
+            sum.solve += t.solve;
+            sum.total += t.total;
+            worst = std::max(worst, t.total);
+        }
+
+        json j;
+        j.emplace("scene", scene);
+        j.emplace("bodies", bodies);
+        j.emplace("steps", steps);
+        j.emplace("threads", threads);
+        j.emplace("integrate", sum.integrate / steps);
+        j.emplace("broadphase", sum.broadphase / steps);
+        j.emplace("narrowphase", sum.narrowphase / steps);
+        j.emplace("solve", sum.solve / steps);
+        j.emplace("total", sum.total / steps);
+        j.emplace("worst", worst);
+        return j;
+
+    }
+
+}
+
+// Usage: pancake_bench_physics [pile|rain|pyramid|all] [bodies] [steps] [threads]
+// Prints the average milliseconds each phase of a step took as JSON, so runs can be compared over time.
+int main(int argc, char** argv) {
+
+    std::string scene = argc > 1 ? argv[1] : "all";
+    int bodies = argc > 2 ? std::max(1, std::atoi(argv[2])) : DEFAULT_BODIES;
+    int steps = argc > 3 ? std::max(1, std::atoi(argv[3])) : DEFAULT_STEPS;
+    int threads = argc > 4 ? std::max(1, std::atoi(argv[4])) : 1;
+
+    std::vector<std::string> scenes;
+    if (scene == "all") {scenes = {"pile", "rain", "pyramid"};}
+    else if (scene == "pile" || scene == "rain" || scene == "pyramid") {scenes = {scene};}
+    else {
+        std::cout << "ERROR::BENCH_PHYSICS::UNKNOWN_SCENE::" << scene << "\n";
+        return 1;
+    }
+
+    json results = json::array();
+    for (const std::string& name : scenes) {results.push_back(run(name, bodies, steps, threads));}
+    std::cout << results.dump(4) << "\n";
+
+    return 0;
+
+}
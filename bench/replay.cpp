@@ -0,0 +1,149 @@
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <glm/glm.hpp>
+
+#include "pancake/core/entity.hpp"
+#include "pancake/physics/world.hpp"
+#include "pancake/physics/force.hpp"
+#include "pancake/physics/collider.hpp"
+#include "pancake/physics/rigidbody.hpp"
+
+using namespace Pancake;
+
+namespace {
+
+    const int BODIES = 2000;
+    const int STEPS = 600;
+    const int INTERVAL = 60;
+    const float TIME_STEP = 1.0f / 60.0f;
+    const float WIDTH = 60.0f;
+
+    Rigidbody* createStatic(World& world, glm::vec2 position, glm::vec2 size) {
+        Entity* entity = new Entity(position.x, position.y);
+        BoxCollider* collider = new BoxCollider();
+        collider->setSize(size);
+        collider->setMass(0.0f);
+        Rigidbody* rigidbody = new Rigidbody();
+        rigidbody->addCollider(collider);
+        entity->addComponent(rigidbody);
+        world.add(rigidbody);
+        return rigidbody;
+    }
+
+    // Drops a pile of every kind of shape into a container, and records the world's checksum every interval.
+    std::vector<unsigned long long> run(int threads) {
+
+        World world(TIME_STEP, glm::vec2(0.0f, -10.0f));
+        world.setThreadCount(threads);
+        world.setDeterministic(true);
+
+        Gravity* gravity = new Gravity();
+        gravity->setAcceleration(0.0f, -10.0f);
+        world.addForceGenerator(gravity);
+
+        createStatic(world, glm::vec2(0.0f, -0.5f), glm::vec2(WIDTH, 1.0f));
+        createStatic(world, glm::vec2(-WIDTH * 0.5f, 50.0f), glm::vec2(1.0f, 100.0f));
+        createStatic(world, glm::vec2(WIDTH * 0.5f, 50.0f), glm::vec2(1.0f, 100.0f));
+
+        // Bodies are not deleted, entities can only be destroyed with a scene.
+        std::mt19937 random(12345);
+        std::uniform_real_distribution<float> jitter(-0.1f, 0.1f);
+        int columns = (int) (WIDTH - 4.0f);
+        for (int i = 0; i < BODIES; i++) {
+
+            Entity* entity = new Entity((i % columns) - (columns * 0.5f) + 0.5f + jitter(random), 1.0f + (i / columns) * 1.2f);
+            entity->setRotation(jitter(random));
+            Rigidbody* rigidbody = new Rigidbody();
+
+            switch (i % 4) {
+                case 0: {
+                    CircleCollider* collider = new CircleCollider();
+                    collider->setRadius(0.45f);
+                    rigidbody->addCollider(collider->setMass(1.0f));
+                    break;
+                }
+                case 1: {
+                    BoxCollider* collider = new BoxCollider();
+                    collider->setSize(glm::vec2(0.9f, 0.6f));
+                    rigidbody->addCollider(collider->setMass(1.0f));
+                    break;
+                }
+                case 2: {
+                    PolygonCollider* collider = new PolygonCollider();
+                    collider->setVertices({glm::vec2(-0.45f, -0.4f), glm::vec2(0.45f, -0.4f), glm::vec2(0.0f, 0.45f)});
+                    rigidbody->addCollider(collider->setMass(1.0f));
+                    break;
+                }
+                default: {
+                    CapsuleCollider* collider = new CapsuleCollider();
+                    collider->setLength(0.5f);
+                    collider->setRadius(0.2f);
+                    rigidbody->addCollider(collider->setMass(1.0f));
+                    break;
+                }
+            }
+
+            rigidbody->setRestitution(0.1f);
+            rigidbody->setFriction(0.4f);
+            rigidbody->addForceGenerator("Gravity");
+            entity->addComponent(rigidbody);
+            world.add(rigidbody);
+
+        }
+
+        std::vector<unsigned long long> checksums;
+        for (int s = 1; s <= STEPS; s++) {
+            world.update(TIME_STEP);
+            if (s % INTERVAL == 0) {checksums.push_back(world.getChecksum());}
+        }
+
+        return checksums;
+
+    }
+
+}
+
+// Runs the same scene with different thread counts and checks the checksums match. With "record <file>" the
+// checksums are written out, and with "verify <file>" they are compared with ones recorded by another build.
+int main(int argc, char** argv) {
+
+    std::string mode = argc > 2 ? argv[1] : "";
+    std::string path = argc > 2 ? argv[2] : "";
+
+    int hardware = std::max(1, (int) std::thread::hardware_concurrency());
+    std::vector<unsigned long long> expected = run(1);
+    bool matched = true;
+
+    for (int threads = 2; threads <= hardware; threads *= 2) {
+        bool same = run(threads) == expected;
+        matched = matched && same;
+        std::cout << "threads: " << threads << "  " << (same ? "matches" : "DIVERGED") << "\n";
+    }
+
+    if (mode == "record") {
+        std::ofstream file(path);
+        for (unsigned long long checksum : expected) {file << checksum << "\n";}
+        std::cout << "recorded " << expected.size() << " checksums to " << path << "\n";
+    }
+
+    else if (mode == "verify") {
+        std::ifstream file(path);
+        std::vector<unsigned long long> recorded;
+        unsigned long long checksum;
+        while (file >> checksum) {recorded.push_back(checksum);}
+        bool same = recorded == expected;
+        matched = matched && same;
+        std::cout << "recording: " << (same ? "matches" : "DIVERGED") << "\n";
+    }
+
+    for (int i = 0; i < expected.size(); i++) {
+        std::cout << "step " << (i + 1) * INTERVAL << "  checksum: " << std::hex << expected[i] << std::dec << "\n";
+    }
+
+    return matched ? 0 : 1;
+
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+
+#include "pancake/core/spatial.hpp"
+
+using namespace Pancake;
+
+namespace {
+
+    const int STEPS = 100;
+    const float TIME_STEP = 1.0f / 60.0f;
+
+    struct Body {
+        glm::vec2 position;
+        glm::vec2 size;
+        glm::vec2 velocity;
+    };
+
+    double milliseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    void run(int n) {
+
+        // Scatter bodies of varying size at a constant density, so cells hold a similar number of bodies at every n.
+        std::mt19937 random(12345);
+        float extent = 2.0f * std::sqrt((float) n);
+        std::uniform_real_distribution<float> position(-extent, extent);
+        std::uniform_real_distribution<float> size(0.25f, 2.0f);
+        std::uniform_real_distribution<float> velocity(-5.0f, 5.0f);
+
+        std::vector<Body> bodies(n);
+        for (Body& b : bodies) {
+            b.position = glm::vec2(position(random), position(random));
+            b.size = glm::vec2(size(random), size(random));
+            b.velocity = glm::vec2(velocity(random), velocity(random));
+        }
+
+        SpatialHashGrid<Body*> grid(4);
+        auto start = std::chrono::steady_clock::now();
+        for (Body& b : bodies) {grid.add(&b, b.position.x, b.position.y, b.size.x, b.size.y);}
+        auto end = std::chrono::steady_clock::now();
+        double insert = milliseconds(start, end);
+
+        double update = 0.0;
+        double pairs = 0.0;
+        long long candidates = 0;
+
+        for (int s = 0; s < STEPS; s++) {
+
+            // Move every body and update its registration.
+            start = std::chrono::steady_clock::now();
+            for (Body& b : bodies) {
+                b.position += b.velocity * TIME_STEP;
+                grid.update(&b, b.position.x, b.position.y, b.size.x, b.size.y);
+            }
+            end = std::chrono::steady_clock::now();
+            update += milliseconds(start, end);
+
+            // Walk every cell and generate the candidate pairs.
+            start = std::chrono::steady_clock::now();
+            for (const SpatialHashGrid<Body*>::Bucket& cell : grid) {
+                for (int i = 0; i < cell.size(); i++) {
+                    for (int j = i + 1; j < cell.size(); j++) {
+                        if (cell[i] != cell[j]) {candidates++;}
+                    }
+                }
+            }
+            end = std::chrono::steady_clock::now();
+            pairs += milliseconds(start, end);
+
+        }
+
+        std::cout << "bodies: " << n
+                  << "  insert: " << insert << " ms"
+                  << "  update/step: " << update / STEPS << " ms"
+                  << "  pairs/step: " << pairs / STEPS << " ms"
+                  << "  broadphase/step: " << (update + pairs) / STEPS << " ms"
+                  << "  candidates/step: " << candidates / STEPS << "\n";
+
+    }
+
+}
+
+int main() {
+    int counts[] = {1000, 10000, 50000};
+    for (int n : counts) {run(n);}
+    return 0;
+}
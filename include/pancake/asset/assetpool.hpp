@@ -25,6 +25,12 @@ namespace Pancake {
         void destroy();
         Texture* get(std::string name);
 
+        // Images loaded while atlasing is on are packed into shared atlases if they are small enough, and sprites
+        // drawing them are mapped to their region. Textures already loaded are not affected. Packed images can
+        // not be repeated by texture coordinates outside of 0 to 1.
+        bool isAtlasing();
+        void setAtlasing(bool atlasing);
+
     }
 
     namespace SpritePool {
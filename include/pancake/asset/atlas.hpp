@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "pancake/graphics/texture.hpp"
+
+namespace Pancake {
+
+    // A texture that small images are packed into as they load, so sprites using them can share a batch.
+    class Atlas {
+
+        private:
+
+            // The top edge of the packed images, a run of columns at one height.
+            class Skyline {
+
+                public:
+
+                    int x;
+                    int y;
+                    int width;
+
+            };
+
+            Texture* texture;
+            int width;
+            int height;
+            std::vector<Skyline> skyline;   // Ordered left to right, covering the whole width.
+
+            int fit(int index, int width, int height);
+            bool pack(int width, int height, int& x, int& y);
+
+        public:
+
+            Atlas(int width, int height);
+            ~Atlas();
+
+            // Packs RGBA pixels, returning a texture for the region they were put in, or nullptr if the atlas is full.
+            Texture* add(std::string name, unsigned char* image, int width, int height);
+
+            Texture* getTexture();
+            int getWidth();
+            int getHeight();
+
+    };
+
+}
@@ -143,4 +143,98 @@ const char* ENTITY_FRAGMENT =
 "    colour = vec3(fEntityId + 1, 0, 0);                              \n"
 "}                                                                    \n";
 
+
+// The same, sampling array textures, where the texture id is the slot of the array plus eight times the layer.
+const char* ARRAY_FRAGMENT = 
+"#version 330 core                                                    \n"
+"                                                                     \n"
+"in vec4 fColour;                                                     \n"
+"in vec2 fTexCoords;                                                  \n"
+"in float fTexId;                                                     \n"
+"in float fEntityId;                                                  \n"
+"                                                                     \n"
+"uniform sampler2DArray uTextures[8];                                 \n"
+"                                                                     \n"
+"out vec4 colour;                                                     \n"
+"                                                                     \n"
+"void main()                                                          \n"
+"{                                                                    \n"
+"    int id = int(fTexId + 0.5);                                      \n"
+"    vec3 uv = vec3(fTexCoords, float(id / 8));                       \n"
+"    switch (id % 8) {                                                \n"
+"        case 0:                                                      \n"
+"            colour = fColour;                                        \n"
+"            break;                                                   \n"
+"        case 1:                                                      \n"
+"            colour = fColour * texture(uTextures[1], uv);            \n"
+"            break;                                                   \n"
+"        case 2:                                                      \n"
+"            colour = fColour * texture(uTextures[2], uv);            \n"
+"            break;                                                   \n"
+"        case 3:                                                      \n"
+"            colour = fColour * texture(uTextures[3], uv);            \n"
+"            break;                                                   \n"
+"        case 4:                                                      \n"
+"            colour = fColour * texture(uTextures[4], uv);            \n"
+"            break;                                                   \n"
+"        case 5:                                                      \n"
+"            colour = fColour * texture(uTextures[5], uv);            \n"
+"            break;                                                   \n"
+"        case 6:                                                      \n"
+"            colour = fColour * texture(uTextures[6], uv);            \n"
+"            break;                                                   \n"
+"        case 7:                                                      \n"
+"            colour = fColour * texture(uTextures[7], uv);            \n"
+"            break;                                                   \n"
+"    }                                                                \n"
+"}                                                                    \n";
+
+const char* ENTITY_ARRAY_FRAGMENT = 
+"#version 330 core                                                    \n"
+"                                                                     \n"
+"in vec4 fColour;                                                     \n"
+"in vec2 fTexCoords;                                                  \n"
+"in float fTexId;                                                     \n"
+"in float fEntityId;                                                  \n"
+"                                                                     \n"
+"uniform sampler2DArray uTextures[8];                                 \n"
+"                                                                     \n"
+"out vec3 colour;                                                     \n"
+"                                                                     \n"
+"void main()                                                          \n"
+"{                                                                    \n"
+"    int id = int(fTexId + 0.5);                                      \n"
+"    vec3 uv = vec3(fTexCoords, float(id / 8));                       \n"
+"    vec4 texColour = vec4(1, 1, 1, 1);                               \n"
+"    switch (id % 8) {                                                \n"
+"        case 1:                                                      \n"
+"            texColour = fColour * texture(uTextures[1], uv);         \n"
+"            break;                                                   \n"
+"        case 2:                                                      \n"
+"            texColour = fColour * texture(uTextures[2], uv);         \n"
+"            break;                                                   \n"
+"        case 3:                                                      \n"
+"            texColour = fColour * texture(uTextures[3], uv);         \n"
+"            break;                                                   \n"
+"        case 4:                                                      \n"
+"            texColour = fColour * texture(uTextures[4], uv);         \n"
+"            break;                                                   \n"
+"        case 5:                                                      \n"
+"            texColour = fColour * texture(uTextures[5], uv);         \n"
+"            break;                                                   \n"
+"        case 6:                                                      \n"
+"            texColour = fColour * texture(uTextures[6], uv);         \n"
+"            break;                                                   \n"
+"        case 7:                                                      \n"
+"            texColour = fColour * texture(uTextures[7], uv);         \n"
+"            break;                                                   \n"
+"    }                                                                \n"
+"                                                                     \n"
+"    if (texColour.a < 0.5) {                                         \n"
+"        discard;                                                     \n"
+"    }                                                                \n"
+"                                                                     \n"
+"    colour = vec3(fEntityId + 1, 0, 0);                              \n"
+"}                                                                    \n";
+
 }
\ No newline at end of file
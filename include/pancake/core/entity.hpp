@@ -2,12 +2,14 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 #include <glm/glm.hpp>
 #include <nlohmann/json.hpp>
 
 namespace Pancake {
 
     class Component;
+    class CollisionListener;
 
     class Entity {
 
@@ -16,6 +18,7 @@ namespace Pancake {
             int id;
             bool started;
             std::vector<Component*> components;
+            std::vector<CollisionListener*> listeners;     // The components that listen for collisions.
             glm::vec2 position;
             glm::vec2 size;
             float rotation;
@@ -45,9 +48,11 @@ namespace Pancake {
             // Getter Methods.
             int getId();
             std::vector<Component*> getComponents();
+            const std::vector<CollisionListener*>& getCollisionListeners();
             glm::vec2 getPosition();
             glm::vec2 getSize();
             float getRotation();
+            std::pair<glm::vec2, glm::vec2> getBounds();
             bool isSerialisable();
             bool isDead();
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace Pancake {
+
+    // A fixed set of worker threads that run batches of jobs. The calling thread takes part in every
+    // batch, so a pool of one thread has no workers and runs everything inline.
+    class JobPool {
+
+        private:
+
+            std::vector<std::thread> workers;
+            std::mutex mutex;
+            std::condition_variable started;
+            std::condition_variable finished;
+
+            std::function<void(int)> job;
+            std::atomic<int> next;
+            int jobs;
+            int busy;
+            int batch;
+            bool stopping;
+
+            void work();
+            void drain();
+
+        public:
+
+            JobPool(int threads);
+            ~JobPool();
+
+            int getThreadCount();
+
+            // Calls the job once for every index in [0, jobs) across the pool, returning once all have finished.
+            void run(int jobs, std::function<void(int)> job);
+
+    };
+
+}
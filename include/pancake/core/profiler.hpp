@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pancake/core/factory.hpp"
+
+namespace Pancake {
+
+    // A timed section of a frame.
+    class ProfileSample {
+
+        public:
+
+            const char* name;   // Zone names are string literals, so only the pointer is kept.
+            int depth;          // How many zones it is nested in.
+            double start;       // Microseconds since the profiler started.
+            double duration;    // Microseconds.
+
+    };
+
+    // A quantity totalled over a frame, such as the bytes uploaded to the GPU.
+    class ProfileCounter {
+
+        public:
+
+            const char* name;
+            double value;
+
+    };
+
+    // The zones timed in one frame, in the order they began, and its counters.
+    class ProfileFrame {
+
+        public:
+
+            std::vector<ProfileSample> samples;
+            std::vector<ProfileCounter> counters;
+            double start;
+            double duration;
+
+    };
+
+    namespace Profiler {
+
+        // How many of the most recent frames are kept.
+        const int FRAMES = 240;
+
+        // The window marks out each frame. Zones are only recorded inside a frame, and only on the thread
+        // that began it, so code that is also run headless or on workers can be instrumented freely.
+        void beginFrame();
+        void endFrame();
+        void begin(const char* name);
+        void end();
+
+        // Adds to a counter of the current frame.
+        void count(const char* name, double value);
+
+        bool isEnabled();
+        void setEnabled(bool enabled);
+
+        // The number of frames kept so far, and one of them by age, where 0 is the last complete frame.
+        int getFrameCount();
+        const ProfileFrame& getFrame(int age);
+
+        // Writes the kept frames in the Chrome trace event format, for chrome://tracing or Perfetto.
+        bool save(std::string filename);
+
+        // The overlay is drawn alongside the console.
+        void open();
+        void close();
+        void toggle();
+        void render();
+        bool opened();
+
+    }
+
+    // Times the enclosing scope.
+    class ProfileZone {
+
+        public:
+
+            ProfileZone(const char* name) {Profiler::begin(name);}
+            ~ProfileZone() {Profiler::end();}
+
+    };
+
+}
+
+#define PROFILE_ZONE(name) Pancake::ProfileZone UNIQUE_VARIABLE_NAME()(name)
@@ -8,7 +8,7 @@
 #include "pancake/core/camera.hpp"
 #include "pancake/core/entity.hpp"
 #include "pancake/core/component.hpp"
-#include "pancake/core/spatial.hpp"
+#include "pancake/core/tree.hpp"
 #include "pancake/graphics/renderer.hpp"
 #include "pancake/physics/world.hpp"
 
@@ -28,7 +28,7 @@ namespace Pancake {
             Camera* camera;
             Renderer* renderer;
             World* physics;
-            SpatialHashGrid<Entity*>* grid;
+            DynamicTree<Entity*>* tree;
 
         public:
 
@@ -55,6 +55,7 @@ namespace Pancake {
             Entity* getEntity(int id);
             Component* getComponent(int id);
             std::unordered_map<int, Component*>* getComponents();
+            std::vector<Entity*> query(glm::vec2 min, glm::vec2 max);
 
     };
 
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cmath>
+#include <cfloat>
 #include <vector>
+#include <cstdint>
+#include <algorithm>
 #include <utility>
+#include <iterator>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -25,56 +30,251 @@ namespace Pancake {
         }
     };
 
+    // Returns the distance along the ray at which it enters the bounds, or -1 if it misses them.
+    inline float raycastBounds(glm::vec2 origin, glm::vec2 direction, glm::vec2 min, glm::vec2 max) {
+
+        float tMin = 0.0f;
+        float tMax = FLT_MAX;
+
+        for (int i = 0; i < 2; i++) {
+
+            // A ray parallel to the slab misses unless it starts inside it.
+            if (direction[i] == 0.0f) {
+                if (origin[i] < min[i] || origin[i] > max[i]) {return -1.0f;}
+                continue;
+            }
+
+            float inverse = 1.0f / direction[i];
+            float t0 = (min[i] - origin[i]) * inverse;
+            float t1 = (max[i] - origin[i]) * inverse;
+            if (t0 > t1) {std::swap(t0, t1);}
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+            if (tMin > tMax) {return -1.0f;}
+
+        }
+
+        return tMin;
+
+    }
+
     template<class T>
     class SpatialHashGrid {
 
-        private: 
+        public:
+
+            // A read only view over the elements of a single occupied cell.
+            class Bucket {
+
+                private:
+                    const T* first;
+                    int count;
+
+                public:
+
+                    Bucket(const T* first, int count) : first(first), count(count) {}
+
+                    int size() const {return this->count;}
+                    bool empty() const {return this->count == 0;}
+                    const T& operator[](int i) const {return this->first[i];}
+                    const T* begin() const {return this->first;}
+                    const T* end() const {return this->first + this->count;}
+
+            };
+
+        private:
+
+            // The bounds of an element and the inclusive range of cells it is registered in.
+            struct Registration {
+                T element;
+                glm::vec2 min;
+                glm::vec2 max;
+                int xMin;
+                int yMin;
+                int xMax;
+                int yMax;
+            };
+
+            // An occupied cell, its elements are stored in members[start, start + count).
+            struct Cell {
+                int x;
+                int y;
+                int start;
+                int count;
+            };
 
             int gridSize;
-            std::unordered_map<std::pair<int, int>, std::unordered_set<T>, IntPairHash, IntPairEqual> grid;
-            std::unordered_map<T, std::vector<std::pair<int, int>>> registrations;
+
+            // Registrations are packed, removal swaps the last registration into the hole.
+            std::vector<Registration> registrations;
+            std::unordered_map<T, int> index;
+
+            // The cell store is rebuilt lazily from the registrations whenever they have changed.
+            // The table is open addressed with linear probing and maps a coordinate to a cell, or -1 if empty.
+            std::vector<int> table;
+            std::vector<Cell> cells;
+            std::vector<T> members;
+            std::vector<int> slots;
+            std::vector<std::pair<int, int>> scratch;
+            int xLower;     // The range of cells with anything registered in them.
+            int yLower;
+            int xUpper;
+            int yUpper;
+            bool dirty;
+
+            static uint32_t hash(int x, int y) {
+                uint32_t h = ((uint32_t) x * 0x8da6b343u) ^ ((uint32_t) y * 0xd8163841u);
+                return h ^ (h >> 16);
+            }
+
+            int find(int x, int y) const {
+                uint32_t mask = (uint32_t) this->table.size() - 1;
+                uint32_t slot = hash(x, y) & mask;
+                while (this->table[slot] != -1) {
+                    const Cell& cell = this->cells[this->table[slot]];
+                    if (cell.x == x && cell.y == y) {return this->table[slot];}
+                    slot = (slot + 1) & mask;
+                }
+                return -1;
+            }
+
+            int findOrInsert(int x, int y) {
+                uint32_t mask = (uint32_t) this->table.size() - 1;
+                uint32_t slot = hash(x, y) & mask;
+                while (this->table[slot] != -1) {
+                    const Cell& cell = this->cells[this->table[slot]];
+                    if (cell.x == x && cell.y == y) {return this->table[slot];}
+                    slot = (slot + 1) & mask;
+                }
+                this->table[slot] = this->cells.size();
+                this->cells.push_back({x, y, 0, 0});
+                return this->table[slot];
+            }
+
+            void range(float x, float y, float w, float h, int& xMin, int& yMin, int& xMax, int& yMax) const {
+                w = std::abs(w);
+                h = std::abs(h);
+                xMin = std::floor((x - 0.5f * w) / this->gridSize);
+                yMin = std::floor((y - 0.5f * h) / this->gridSize);
+                xMax = std::floor((x + 0.5f * w) / this->gridSize);
+                yMax = std::floor((y + 0.5f * h) / this->gridSize);
+            }
+
+            void rebuild() {
+
+                if (!this->dirty) {return;}
+
+                // Size the table so that it is at most half full, even if every registered cell is distinct.
+                size_t total = 0;
+                for (const Registration& r : this->registrations) {total += (size_t) (r.xMax - r.xMin + 1) * (r.yMax - r.yMin + 1);}
+                size_t capacity = 16;
+                while (capacity < 2 * total) {capacity <<= 1;}
+                this->table.assign(capacity, -1);
+                this->cells.clear();
+                this->scratch.clear();
+                this->xLower = INT32_MAX;
+                this->yLower = INT32_MAX;
+                this->xUpper = INT32_MIN;
+                this->yUpper = INT32_MIN;
+
+                // Count the elements in each cell.
+                int n = this->registrations.size();
+                for (int k = 0; k < n; k++) {
+                    const Registration& r = this->registrations[k];
+                    this->xLower = std::min(this->xLower, r.xMin);
+                    this->yLower = std::min(this->yLower, r.yMin);
+                    this->xUpper = std::max(this->xUpper, r.xMax);
+                    this->yUpper = std::max(this->yUpper, r.yMax);
+                    for (int i = r.xMin; i <= r.xMax; i++) {
+                        for (int j = r.yMin; j <= r.yMax; j++) {
+                            int c = this->findOrInsert(i, j);
+                            this->cells[c].count++;
+                            this->scratch.push_back(std::make_pair(c, k));
+                        }
+                    }
+                }
+
+                // Assign each cell its range in the packed member array.
+                int offset = 0;
+                for (Cell& cell : this->cells) {
+                    cell.start = offset;
+                    offset += cell.count;
+                    cell.count = 0;
+                }
+
+                // Scatter the elements into their cells.
+                this->members.resize(offset);
+                this->slots.resize(offset);
+                for (const std::pair<int, int>& p : this->scratch) {
+                    Cell& cell = this->cells[p.first];
+                    this->members[cell.start + cell.count] = this->registrations[p.second].element;
+                    this->slots[cell.start + cell.count] = p.second;
+                    cell.count++;
+                }
+
+                this->dirty = false;
+
+            }
 
         public:
 
             SpatialHashGrid<T>(float gridSize) {
                 this->gridSize = std::abs(gridSize);
+                this->table.assign(16, -1);
+                this->xLower = 0;
+                this->yLower = 0;
+                this->xUpper = -1;
+                this->yUpper = -1;
+                this->dirty = false;
+            }
+
+            // Brings the cells up to date with the registrations. Queries do this themselves, but after it they
+            // only read, so several can run at once.
+            void prepare() {
+                this->rebuild();
             }
 
             int getGridSize() {
                 return this->gridSize;
             }
 
-            void add(T element, float x, float y, float w, float h) {
-
-                auto it = this->registrations.find(element);
-                if (it != this->registrations.end()) {this->remove(element);}
+            // Changes the size of the cells, keeping every element registered with the bounds it was last given.
+            void setGridSize(int gridSize) {
+                this->gridSize = std::abs(gridSize);
+                for (Registration& r : this->registrations) {
+                    glm::vec2 centre = 0.5f * (r.min + r.max);
+                    glm::vec2 size = r.max - r.min;
+                    this->range(centre.x, centre.y, size.x, size.y, r.xMin, r.yMin, r.xMax, r.yMax);
+                }
+                this->dirty = true;
+            }
 
-                std::vector<std::pair<int, int>> coordinates;
-                std::pair<int, int> coordinate;
+            int size() {
+                return this->registrations.size();
+            }
 
-                w = std::abs(w);
-                h = std::abs(h);
-                int x_min = std::floor((x - 0.5f * w) / this->gridSize);
-                int y_min = std::floor((y - 0.5f * h) / this->gridSize);
-                int x_max = std::floor((x + 0.5f * w) / this->gridSize);
-                int y_max = std::floor((y + 0.5f * h) / this->gridSize);
-                
-                for (int i = x_min; i <= x_max; i++) {
-                    for (int j = y_min; j <= y_max; j++) {
-
-                        coordinate = std::make_pair(i, j);
-                        coordinates.push_back(coordinate);
-                        
-                        auto it = this->grid.find(coordinate);
-                        if (it == this->grid.end()) {std::unordered_set<T> set; this->grid.insert(std::make_pair(coordinate, set));}
-
-                        auto search = this->grid.find(coordinate);
-                        search->second.insert(element);
+            void add(T element, float x, float y, float w, float h) {
 
-                    }
+                int xMin, yMin, xMax, yMax;
+                this->range(x, y, w, h, xMin, yMin, xMax, yMax);
+                glm::vec2 min = glm::vec2(x - 0.5f * std::abs(w), y - 0.5f * std::abs(h));
+                glm::vec2 max = glm::vec2(x + 0.5f * std::abs(w), y + 0.5f * std::abs(h));
+
+                // If the element is already registered, only move it if it has changed cells.
+                auto it = this->index.find(element);
+                if (it != this->index.end()) {
+                    Registration& r = this->registrations[it->second];
+                    r.min = min;
+                    r.max = max;
+                    if (r.xMin == xMin && r.yMin == yMin && r.xMax == xMax && r.yMax == yMax) {return;}
+                    r.xMin = xMin; r.yMin = yMin; r.xMax = xMax; r.yMax = yMax;
+                    this->dirty = true;
+                    return;
                 }
 
-                this->registrations.insert({element, coordinates});
+                this->index.insert({element, (int) this->registrations.size()});
+                this->registrations.push_back({element, min, max, xMin, yMin, xMax, yMax});
+                this->dirty = true;
 
             }
 
@@ -95,26 +295,22 @@ namespace Pancake {
             }
 
             std::unordered_set<T> get(float x, float y, float w, float h) {
-                
+
                 std::unordered_set<T> result;
-                std::pair<int, int> coordinate;
+                this->rebuild();
 
-                w = std::abs(w);
-                h = std::abs(h);
-                int x_min = std::floor((x - 0.5f * w) / this->gridSize);
-                int y_min = std::floor((y - 0.5f * h) / this->gridSize);
-                int x_max = std::floor((x + 0.5f * w) / this->gridSize);
-                int y_max = std::floor((y + 0.5f * h) / this->gridSize);
-                
-                for (int i = x_min; i <= x_max; i++) {
-                    for (int j = y_min; j <= y_max; j++) {
-                        coordinate = std::make_pair(i, j);
-                        auto search = this->grid.find(coordinate);
-                        if (search == this->grid.end()) {continue;}
-                        for (const auto& element : search->second) {result.insert(element);}
+                int xMin, yMin, xMax, yMax;
+                this->range(x, y, w, h, xMin, yMin, xMax, yMax);
+
+                for (int i = xMin; i <= xMax; i++) {
+                    for (int j = yMin; j <= yMax; j++) {
+                        int c = this->find(i, j);
+                        if (c == -1) {continue;}
+                        const Cell& cell = this->cells[c];
+                        for (int k = 0; k < cell.count; k++) {result.insert(this->members[cell.start + k]);}
                     }
                 }
-                
+
                 return result;
 
             }
@@ -122,63 +318,202 @@ namespace Pancake {
             std::unordered_set<T> get(int x, int y) {
 
                 std::unordered_set<T> result;
-                std::pair<int, int> coordinate = std::make_pair(x, y);
+                this->rebuild();
+
+                int c = this->find(x, y);
+                if (c == -1) {return result;}
+                const Cell& cell = this->cells[c];
+                for (int k = 0; k < cell.count; k++) {result.insert(this->members[cell.start + k]);}
+                return result;
+
+            }
+
+            // Finds every pair of elements whose bounds overlap. Each pair is reported once, from the first cell they share.
+            void pairs(std::vector<std::pair<T, T>>& result) {
+                this->pairs(result, [](const T& a, const T& b) {return true;});
+            }
+
+            // The same, leaving out the pairs the filter rejects.
+            template<class F>
+            void pairs(std::vector<std::pair<T, T>>& result, F filter) {
+
+                this->rebuild();
 
-                auto search = this->grid.find(coordinate);
-                if (search == this->grid.end()) {return result;}
-                return search->second;
+                for (const Cell& cell : this->cells) {
+                    for (int i = 0; i < cell.count; i++) {
+
+                        const Registration& a = this->registrations[this->slots[cell.start + i]];
+                        for (int j = i + 1; j < cell.count; j++) {
+
+                            const Registration& b = this->registrations[this->slots[cell.start + j]];
+                            if (std::max(a.xMin, b.xMin) != cell.x || std::max(a.yMin, b.yMin) != cell.y) {continue;}
+                            if (a.max.x < b.min.x || b.max.x < a.min.x || a.max.y < b.min.y || b.max.y < a.min.y) {continue;}
+                            if (!filter(a.element, b.element)) {continue;}
+                            result.push_back(std::make_pair(a.element, b.element));
+
+                        }
+
+                    }
+                }
+
+            }
+
+            // Finds every element whose bounds overlap the region. Each element is reported once.
+            void query(glm::vec2 min, glm::vec2 max, std::vector<T>& result) {
+
+                this->rebuild();
+
+                int xMin, yMin, xMax, yMax;
+                this->range(0.5f * (min.x + max.x), 0.5f * (min.y + max.y), max.x - min.x, max.y - min.y, xMin, yMin, xMax, yMax);
+
+                for (int i = xMin; i <= xMax; i++) {
+                    for (int j = yMin; j <= yMax; j++) {
+
+                        int c = this->find(i, j);
+                        if (c == -1) {continue;}
+
+                        const Cell& cell = this->cells[c];
+                        for (int k = 0; k < cell.count; k++) {
+                            const Registration& r = this->registrations[this->slots[cell.start + k]];
+                            if (std::max(r.xMin, xMin) != i || std::max(r.yMin, yMin) != j) {continue;}
+                            if (r.max.x < min.x || max.x < r.min.x || r.max.y < min.y || max.y < r.min.y) {continue;}
+                            result.push_back(r.element);
+                        }
+
+                    }
+                }
+
+            }
+
+            // Calls back with every element whose bounds the ray passes through, within the distance last returned by the callback.
+            // The cells along the ray are walked in order, so elements come roughly nearest first.
+            template<class F>
+            void raycast(glm::vec2 origin, glm::vec2 direction, float distance, F callback) {
+
+                this->rebuild();
+                if (this->registrations.empty()) {return;}
+
+                // Clip the ray to the occupied cells, so the walk has an end.
+                float size = this->gridSize;
+                glm::vec2 lower = glm::vec2(this->xLower, this->yLower) * size;
+                glm::vec2 upper = glm::vec2(this->xUpper + 1, this->yUpper + 1) * size;
+                float enter = 0.0f;
+                float exit = distance;
+                for (int i = 0; i < 2; i++) {
+                    if (direction[i] == 0.0f) {
+                        if (origin[i] < lower[i] || origin[i] > upper[i]) {return;}
+                        continue;
+                    }
+                    float t0 = (lower[i] - origin[i]) / direction[i];
+                    float t1 = (upper[i] - origin[i]) / direction[i];
+                    if (t0 > t1) {std::swap(t0, t1);}
+                    enter = std::max(enter, t0);
+                    exit = std::min(exit, t1);
+                }
+                if (enter > exit) {return;}
+
+                // A long ray through a sparse grid visits more empty cells than there are elements, so just test them all.
+                float cells = (std::abs(direction.x) + std::abs(direction.y)) * (exit - enter) / size;
+                if (cells > this->registrations.size()) {
+                    for (const Registration& r : this->registrations) {
+                        float t = raycastBounds(origin, direction, r.min, r.max);
+                        if (t < 0.0f || t > distance) {continue;}
+                        distance = std::min(distance, (float) callback(r.element));
+                    }
+                    return;
+                }
+
+                // Walk the cells along the ray, starting from the one it enters the occupied cells in.
+                glm::vec2 start = origin + direction * enter;
+                int x = std::min(std::max((int) std::floor(start.x / size), this->xLower), this->xUpper);
+                int y = std::min(std::max((int) std::floor(start.y / size), this->yLower), this->yUpper);
+                int xStep = direction.x > 0.0f ? 1 : -1;
+                int yStep = direction.y > 0.0f ? 1 : -1;
+                float xNext = direction.x == 0.0f ? FLT_MAX : ((x + (xStep > 0 ? 1 : 0)) * size - origin.x) / direction.x;
+                float yNext = direction.y == 0.0f ? FLT_MAX : ((y + (yStep > 0 ? 1 : 0)) * size - origin.y) / direction.y;
+                float xDelta = direction.x == 0.0f ? FLT_MAX : size / std::abs(direction.x);
+                float yDelta = direction.y == 0.0f ? FLT_MAX : size / std::abs(direction.y);
+
+                int xPrevious = INT32_MIN;
+                int yPrevious = INT32_MIN;
+                float t = enter;
+                while (t <= distance && x >= this->xLower && x <= this->xUpper && y >= this->yLower && y <= this->yUpper) {
+
+                    int c = this->find(x, y);
+                    if (c != -1) {
+                        const Cell& cell = this->cells[c];
+                        for (int k = 0; k < cell.count; k++) {
+
+                            // The cells of an element along the ray are consecutive, so it is reported from the first.
+                            const Registration& r = this->registrations[this->slots[cell.start + k]];
+                            if (xPrevious >= r.xMin && xPrevious <= r.xMax && yPrevious >= r.yMin && yPrevious <= r.yMax) {continue;}
+
+                            float hit = raycastBounds(origin, direction, r.min, r.max);
+                            if (hit < 0.0f || hit > distance) {continue;}
+                            distance = std::min(distance, (float) callback(r.element));
+
+                        }
+                    }
+
+                    xPrevious = x;
+                    yPrevious = y;
+                    if (xNext < yNext) {t = xNext; xNext += xDelta; x += xStep;}
+                    else {t = yNext; yNext += yDelta; y += yStep;}
+
+                }
 
             }
 
             void remove(T element) {
 
-                auto s0 = this->registrations.find(element);
-                if (s0 == this->registrations.end()) {return;}
-                
-                for (std::pair<int, int> location : s0->second) {
-                    auto s1 = this->grid.find(location);
-                    if (s1 == this->grid.end()) {continue;}
-                    s1->second.erase(element);
-                    if (s1->second.empty()) {this->grid.erase(location);}
+                auto it = this->index.find(element);
+                if (it == this->index.end()) {return;}
+
+                // Swap the last registration into the removed slot.
+                int slot = it->second;
+                int last = this->registrations.size() - 1;
+                if (slot != last) {
+                    this->registrations[slot] = this->registrations[last];
+                    this->index[this->registrations[slot].element] = slot;
                 }
 
-                this->registrations.erase(element);
-            
+                this->registrations.pop_back();
+                this->index.erase(element);
+                this->dirty = true;
+
             }
 
             void clear() {
-                this->grid.clear();
                 this->registrations.clear();
+                this->index.clear();
+                this->table.assign(16, -1);
+                this->cells.clear();
+                this->members.clear();
+                this->slots.clear();
+                this->scratch.clear();
+                this->dirty = false;
             }
 
+            // Iterates over the occupied cells. Elements removed during iteration remain visible until the next begin().
             class iterator {
 
                 public:
                     using iterator_category = std::forward_iterator_tag;
-                    using value_type = std::vector<T>;
+                    using value_type = Bucket;
                     using difference_type = std::ptrdiff_t;
-                    using pointer = std::vector<T>*;
-                    using reference = std::vector<T>&;
+                    using pointer = Bucket*;
+                    using reference = Bucket;
 
                 private:
-                    typename std::unordered_map<std::pair<int, int>, std::unordered_set<T>, IntPairHash, IntPairEqual>::iterator gridIterator;
-                    SpatialHashGrid<T>& grid;
-                    std::vector<T> currentVector;
+                    const SpatialHashGrid<T>* grid;
+                    int cell;
 
                 public:
 
-                    iterator(typename std::unordered_map<std::pair<int, int>, std::unordered_set<T>, IntPairHash, IntPairEqual>::iterator gridIter, SpatialHashGrid<T>& grid)
-                        : gridIterator(gridIter), grid(grid) {
-                        if (gridIterator != grid.grid.end()) {
-                            currentVector = std::vector<T>(gridIterator->second.begin(), gridIterator->second.end());
-                        }
-                    }
+                    iterator(const SpatialHashGrid<T>* grid, int cell) : grid(grid), cell(cell) {}
 
                     iterator& operator++() {
-                        ++gridIterator;
-                        if (gridIterator != grid.grid.end()) {
-                            currentVector = std::vector<T>(gridIterator->second.begin(), gridIterator->second.end());
-                        }
+                        ++this->cell;
                         return *this;
                     }
 
@@ -189,26 +524,29 @@ namespace Pancake {
                     }
 
                     bool operator==(const iterator& other) const {
-                        return gridIterator == other.gridIterator;
+                        return this->cell == other.cell;
                     }
 
                     bool operator!=(const iterator& other) const {
                         return !(*this == other);
                     }
 
-                    std::vector<T>& operator*() {
-                        return currentVector;
+                    Bucket operator*() const {
+                        const Cell& c = this->grid->cells[this->cell];
+                        return Bucket(this->grid->members.data() + c.start, c.count);
                     }
                 };
 
             iterator begin() {
-                return iterator(grid.begin(), *this);
+                this->rebuild();
+                return iterator(this, 0);
             }
 
+            // Does not rebuild, so comparing against end() inside a loop that removes elements is safe.
             iterator end() {
-                return iterator(grid.end(), *this);
+                return iterator(this, this->cells.size());
             }
 
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <cmath>
+#include <cfloat>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#include "pancake/core/spatial.hpp"
+
+namespace Pancake {
+
+    // A bounding volume hierarchy over fattened bounds. Leaves are only reinserted when their bounds
+    // leave their fattened bounds, and the tree is kept balanced with rotations as it changes.
+    template<class T>
+    class DynamicTree {
+
+        private:
+
+            struct Node {
+                glm::vec2 min;      // Fattened bounds for all nodes.
+                glm::vec2 max;
+                glm::vec2 tightMin; // Exact bounds, only used by leaves.
+                glm::vec2 tightMax;
+                T element;
+                int parent;         // The next free node when the node is unused.
+                int left;
+                int right;
+                int height;         // Leaves have a height of 0, unused nodes have a height of -1.
+            };
+
+            // Deeper than any balanced tree that fits in memory.
+            static const int MAX_DEPTH = 128;
+
+            float margin;
+            int root;
+            int freeList;
+            std::vector<Node> nodes;
+            std::unordered_map<T, int> index;
+            std::vector<int> stack;
+
+            static float perimeter(glm::vec2 min, glm::vec2 max) {
+                return 2.0f * ((max.x - min.x) + (max.y - min.y));
+            }
+
+            static bool overlaps(glm::vec2 aMin, glm::vec2 aMax, glm::vec2 bMin, glm::vec2 bMax) {
+                return !(aMax.x < bMin.x || bMax.x < aMin.x || aMax.y < bMin.y || bMax.y < aMin.y);
+            }
+
+            static bool contains(glm::vec2 outerMin, glm::vec2 outerMax, glm::vec2 innerMin, glm::vec2 innerMax) {
+                return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && innerMax.x <= outerMax.x && innerMax.y <= outerMax.y;
+            }
+
+            int allocate() {
+
+                if (this->freeList == -1) {
+                    Node node;
+                    node.height = -1;
+                    node.parent = -1;
+                    this->nodes.push_back(node);
+                    this->freeList = this->nodes.size() - 1;
+                }
+
+                int node = this->freeList;
+                this->freeList = this->nodes[node].parent;
+                this->nodes[node].parent = -1;
+                this->nodes[node].left = -1;
+                this->nodes[node].right = -1;
+                this->nodes[node].height = 0;
+                return node;
+
+            }
+
+            void release(int node) {
+                this->nodes[node].parent = this->freeList;
+                this->nodes[node].height = -1;
+                this->freeList = node;
+            }
+
+            void refit(int node) {
+                Node& n = this->nodes[node];
+                const Node& l = this->nodes[n.left];
+                const Node& r = this->nodes[n.right];
+                n.min = glm::vec2(std::min(l.min.x, r.min.x), std::min(l.min.y, r.min.y));
+                n.max = glm::vec2(std::max(l.max.x, r.max.x), std::max(l.max.y, r.max.y));
+                n.height = 1 + std::max(l.height, r.height);
+            }
+
+            // Promotes the taller child x of a into a's place, a takes x's shorter child.
+            int rotate(int a, int x) {
+
+                Node& A = this->nodes[a];
+                Node& X = this->nodes[x];
+                int f = X.left;
+                int g = X.right;
+
+                // Swap a and x.
+                X.left = a;
+                X.parent = A.parent;
+                A.parent = x;
+
+                if (X.parent == -1) {this->root = x;}
+                else if (this->nodes[X.parent].left == a) {this->nodes[X.parent].left = x;}
+                else {this->nodes[X.parent].right = x;}
+
+                // Keep the taller grandchild with x, and give the shorter one to a.
+                int moved = f;
+                if (this->nodes[f].height > this->nodes[g].height) {X.right = f; moved = g;}
+                else {X.right = g;}
+
+                if (A.left == x) {A.left = moved;}
+                else {A.right = moved;}
+                this->nodes[moved].parent = a;
+
+                this->refit(a);
+                this->refit(x);
+                return x;
+
+            }
+
+            int balance(int node) {
+
+                const Node& n = this->nodes[node];
+                if (n.left == -1 || n.height < 2) {return node;}
+
+                int difference = this->nodes[n.right].height - this->nodes[n.left].height;
+                if (difference > 1) {return this->rotate(node, n.right);}
+                if (difference < -1) {return this->rotate(node, n.left);}
+                return node;
+
+            }
+
+            // Walks up from the node, rebalancing and refitting every ancestor.
+            void ascend(int node) {
+                while (node != -1) {
+                    node = this->balance(node);
+                    this->refit(node);
+                    node = this->nodes[node].parent;
+                }
+            }
+
+            void insertLeaf(int leaf) {
+
+                if (this->root == -1) {
+                    this->root = leaf;
+                    this->nodes[leaf].parent = -1;
+                    return;
+                }
+
+                // Descend towards the sibling that least increases the total perimeter of the tree.
+                glm::vec2 min = this->nodes[leaf].min;
+                glm::vec2 max = this->nodes[leaf].max;
+                int node = this->root;
+
+                while (this->nodes[node].left != -1) {
+
+                    const Node& n = this->nodes[node];
+                    glm::vec2 combinedMin = glm::vec2(std::min(n.min.x, min.x), std::min(n.min.y, min.y));
+                    glm::vec2 combinedMax = glm::vec2(std::max(n.max.x, max.x), std::max(n.max.y, max.y));
+                    float combined = perimeter(combinedMin, combinedMax);
+
+                    // The cost of creating a new parent here, and the cost pushed down to the children.
+                    float cost = 2.0f * combined;
+                    float inheritance = 2.0f * (combined - perimeter(n.min, n.max));
+
+                    float costs[2];
+                    int children[2] = {n.left, n.right};
+                    for (int i = 0; i < 2; i++) {
+                        const Node& c = this->nodes[children[i]];
+                        float enlarged = perimeter(glm::vec2(std::min(c.min.x, min.x), std::min(c.min.y, min.y)), glm::vec2(std::max(c.max.x, max.x), std::max(c.max.y, max.y)));
+                        if (c.left == -1) {costs[i] = enlarged + inheritance;}
+                        else {costs[i] = enlarged - perimeter(c.min, c.max) + inheritance;}
+                    }
+
+                    if (cost < costs[0] && cost < costs[1]) {break;}
+                    node = costs[0] < costs[1] ? children[0] : children[1];
+
+                }
+
+                // Create a new parent for the sibling and the leaf.
+                int sibling = node;
+                int oldParent = this->nodes[sibling].parent;
+                int newParent = this->allocate();
+
+                this->nodes[newParent].parent = oldParent;
+                this->nodes[newParent].left = sibling;
+                this->nodes[newParent].right = leaf;
+                this->nodes[sibling].parent = newParent;
+                this->nodes[leaf].parent = newParent;
+
+                if (oldParent == -1) {this->root = newParent;}
+                else if (this->nodes[oldParent].left == sibling) {this->nodes[oldParent].left = newParent;}
+                else {this->nodes[oldParent].right = newParent;}
+
+                this->ascend(newParent);
+
+            }
+
+            void removeLeaf(int leaf) {
+
+                if (leaf == this->root) {
+                    this->root = -1;
+                    return;
+                }
+
+                int parent = this->nodes[leaf].parent;
+                int grandParent = this->nodes[parent].parent;
+                int sibling = this->nodes[parent].left == leaf ? this->nodes[parent].right : this->nodes[parent].left;
+
+                // Replace the parent with the sibling.
+                this->nodes[sibling].parent = grandParent;
+                this->release(parent);
+
+                if (grandParent == -1) {
+                    this->root = sibling;
+                    return;
+                }
+
+                if (this->nodes[grandParent].left == parent) {this->nodes[grandParent].left = sibling;}
+                else {this->nodes[grandParent].right = sibling;}
+                this->ascend(grandParent);
+
+            }
+
+        public:
+
+            DynamicTree<T>(float margin) {
+                this->margin = std::abs(margin);
+                this->root = -1;
+                this->freeList = -1;
+            }
+
+            float getMargin() {
+                return this->margin;
+            }
+
+            // Changes the margin, keeping every element registered with the bounds it was last given. The leaves
+            // are reinserted in the order they are stored, so the rebuilt tree does not depend on their addresses.
+            void setMargin(float margin) {
+
+                std::vector<std::pair<T, std::pair<glm::vec2, glm::vec2>>> leaves;
+                for (const Node& n : this->nodes) {
+                    if (n.height == 0) {leaves.push_back(std::make_pair(n.element, std::make_pair(n.tightMin, n.tightMax)));}
+                }
+
+                this->clear();
+                this->margin = std::abs(margin);
+                for (const auto& leaf : leaves) {this->add(leaf.first, leaf.second.first, leaf.second.second);}
+
+            }
+
+            int getHeight() {
+                if (this->root == -1) {return 0;}
+                return this->nodes[this->root].height;
+            }
+
+            int size() {
+                return this->index.size();
+            }
+
+            void add(T element, glm::vec2 min, glm::vec2 max) {
+
+                auto it = this->index.find(element);
+                if (it != this->index.end()) {this->update(element, min, max); return;}
+
+                int leaf = this->allocate();
+                Node& n = this->nodes[leaf];
+                n.element = element;
+                n.tightMin = min;
+                n.tightMax = max;
+                n.min = min - glm::vec2(this->margin, this->margin);
+                n.max = max + glm::vec2(this->margin, this->margin);
+
+                this->index.insert({element, leaf});
+                this->insertLeaf(leaf);
+
+            }
+
+            // Returns true if the element had to be reinserted because it left its fattened bounds.
+            bool update(T element, glm::vec2 min, glm::vec2 max) {
+
+                auto it = this->index.find(element);
+                if (it == this->index.end()) {this->add(element, min, max); return true;}
+
+                int leaf = it->second;
+                this->nodes[leaf].tightMin = min;
+                this->nodes[leaf].tightMax = max;
+                if (contains(this->nodes[leaf].min, this->nodes[leaf].max, min, max)) {return false;}
+
+                this->removeLeaf(leaf);
+                this->nodes[leaf].min = min - glm::vec2(this->margin, this->margin);
+                this->nodes[leaf].max = max + glm::vec2(this->margin, this->margin);
+                this->insertLeaf(leaf);
+                return true;
+
+            }
+
+            void remove(T element) {
+                auto it = this->index.find(element);
+                if (it == this->index.end()) {return;}
+                this->removeLeaf(it->second);
+                this->release(it->second);
+                this->index.erase(it);
+            }
+
+            void clear() {
+                this->nodes.clear();
+                this->index.clear();
+                this->root = -1;
+                this->freeList = -1;
+            }
+
+            // Finds every element whose bounds overlap the region.
+            // Queries and raycasts only read the tree, so several can run at once. Their stacks live on the call
+            // stack instead, which is never deeper than the balanced tree's height.
+            void query(glm::vec2 min, glm::vec2 max, std::vector<T>& result) {
+
+                if (this->root == -1) {return;}
+                int stack[MAX_DEPTH];
+                int top = 0;
+                stack[top++] = this->root;
+
+                while (top > 0) {
+
+                    int node = stack[--top];
+                    const Node& n = this->nodes[node];
+                    if (!overlaps(n.min, n.max, min, max)) {continue;}
+
+                    if (n.left == -1) {if (overlaps(n.tightMin, n.tightMax, min, max)) {result.push_back(n.element);}}
+                    else {stack[top++] = n.left; stack[top++] = n.right;}
+
+                }
+
+            }
+
+            // Calls back with every element whose bounds the ray passes through, within the distance last returned by the callback.
+            template<class F>
+            void raycast(glm::vec2 origin, glm::vec2 direction, float distance, F callback) {
+
+                if (this->root == -1) {return;}
+                int stack[MAX_DEPTH];
+                int top = 0;
+                stack[top++] = this->root;
+
+                while (top > 0) {
+
+                    int node = stack[--top];
+                    const Node& n = this->nodes[node];
+
+                    float t = raycastBounds(origin, direction, n.min, n.max);
+                    if (t < 0.0f || t > distance) {continue;}
+
+                    if (n.left != -1) {stack[top++] = n.left; stack[top++] = n.right; continue;}
+
+                    t = raycastBounds(origin, direction, n.tightMin, n.tightMax);
+                    if (t < 0.0f || t > distance) {continue;}
+                    distance = std::min(distance, (float) callback(n.element));
+
+                }
+
+            }
+
+            // Finds every pair of elements whose bounds overlap, each pair exactly once.
+            void pairs(std::vector<std::pair<T, T>>& result) {
+                this->pairs(result, [](const T& a, const T& b) {return true;});
+            }
+
+            // The same, leaving out the pairs the filter rejects.
+            template<class F>
+            void pairs(std::vector<std::pair<T, T>>& result, F filter) {
+
+                int n = this->nodes.size();
+                for (int leaf = 0; leaf < n; leaf++) {
+
+                    if (this->nodes[leaf].height != 0) {continue;}
+                    glm::vec2 min = this->nodes[leaf].tightMin;
+                    glm::vec2 max = this->nodes[leaf].tightMax;
+
+                    this->stack.clear();
+                    this->stack.push_back(this->root);
+
+                    while (!this->stack.empty()) {
+
+                        int node = this->stack.back();
+                        this->stack.pop_back();
+                        const Node& other = this->nodes[node];
+                        if (!overlaps(other.min, other.max, min, max)) {continue;}
+
+                        if (other.left != -1) {this->stack.push_back(other.left); this->stack.push_back(other.right); continue;}
+                        if (node <= leaf) {continue;}
+                        if (!overlaps(other.tightMin, other.tightMax, min, max)) {continue;}
+                        if (!filter(this->nodes[leaf].element, other.element)) {continue;}
+                        result.push_back(std::make_pair(this->nodes[leaf].element, other.element));
+
+                    }
+
+                }
+
+            }
+
+    };
+
+}
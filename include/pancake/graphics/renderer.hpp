@@ -2,7 +2,9 @@
 
 #include <deque>
 #include <vector>
+#include <utility>
 #include "pancake/graphics/texture.hpp"
+#include "pancake/graphics/texturearray.hpp"
 #include "pancake/graphics/shader.hpp"
 #include "pancake/graphics/spriterenderer.hpp"
 
@@ -28,8 +30,21 @@ namespace Pancake {
             void add(SpriteRenderer* sprite);
             void remove(SpriteRenderer* sprite);
             static void bindShader(Shader* shader);
+            static void bindShader(Shader* shader, Shader* arrayShader);
             static Shader* getBoundShader(Shader* shader);
 
+            // Streamed batches write their vertices into a ring of buffer regions, mapped without synchronising,
+            // so an upload never waits for the GPU to finish reading the last frame. Only affects batches created
+            // afterwards, and falls back to plain uploads where fences are not supported.
+            static bool isStreaming();
+            static void setStreaming(bool streaming);
+
+            // Batches using texture arrays bind arrays of same sized textures instead of single textures, so
+            // a batch is only limited by its quad count unless it draws textures of many different sizes.
+            // Only affects batches created afterwards.
+            static bool isUsingTextureArrays();
+            static void setUsingTextureArrays(bool arrays);
+
     };
 
     class RenderBatch {
@@ -39,12 +54,24 @@ namespace Pancake {
             Renderer* renderer;
             vector<SpriteRenderer*> sprites;
             vector<Texture*> textures;
+            vector<TextureArray*> arrays;
+            bool arrayed;
             
             float* vertices;
             unsigned int vao;
             unsigned int vbo;
             int zIndex;
 
+            vector<std::pair<int, int>> dirty;  // Ranges of quads changed since the last upload, first and last.
+
+            bool streaming;
+            int region;                         // The region of the ring last written, which is drawn.
+            vector<GLsync> fences;              // Signalled when the GPU has finished drawing from each region.
+
+            void setDirty(int first, int last);
+            void upload();
+            void stream();
+
         public:
 
             RenderBatch(Renderer* renderer, int zIndex);
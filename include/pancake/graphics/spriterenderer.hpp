@@ -10,6 +10,8 @@ using glm::vec4;
 
 namespace Pancake {
 
+    class RenderBatch;
+
     class SpriteRenderer : public TransformableComponent {
 
         private:
@@ -27,6 +29,9 @@ namespace Pancake {
             
             bool dirty;
 
+            RenderBatch* batch; // The batch drawing the sprite, and its quad within it.
+            int slot;
+
         public:
 
             SpriteRenderer();
@@ -42,6 +47,8 @@ namespace Pancake {
             vec4 getColour();
             int getZIndex();
             bool isDirty();
+            RenderBatch* getBatch();
+            int getSlot();
             
             // Setters
             SpriteRenderer* setSprite(string sprite);
@@ -52,6 +59,7 @@ namespace Pancake {
             SpriteRenderer* setColour(float r, float g, float b);
             SpriteRenderer* setZIndex(int zIndex);
             SpriteRenderer* setClean();
+            SpriteRenderer* setBatch(RenderBatch* batch, int slot);
 
     };
 
@@ -2,11 +2,15 @@
 
 #include <string>
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 
 using std::string;
+using glm::vec2;
 
 namespace Pancake {
 
+    class TextureArray;
+
     class Texture {
 
         private:
@@ -17,6 +21,13 @@ namespace Pancake {
             int height;
             bool missingFlag;
 
+            TextureArray* array;    // The array texture holding a copy of this one, and its layer, if any.
+            int layer;
+
+            Texture* atlas;         // The texture this image was packed into, if any, and where within it.
+            vec2 regionMin;
+            vec2 regionMax;
+
             void init(string name, unsigned char* image, int width, int height, int channels);
             void generate(GLint internal, int width, int height, GLenum format, GLenum type);
             void missing();
@@ -27,16 +38,28 @@ namespace Pancake {
             Texture(string filename);
             Texture(string name, unsigned char* image, int width, int height, int channels);
             Texture(GLint internal, int width, int height, GLenum format, GLenum type);
+            Texture(string name, Texture* atlas, vec2 regionMin, vec2 regionMax, int width, int height);
             ~Texture();
 
             void bind();
             void unbind();
+
+            // Replaces a rectangle of RGBA pixels.
+            void update(int x, int y, int width, int height, unsigned char* pixels);
             
             string getName();
             unsigned int getId();
             int getWidth();
             int getHeight();
             bool isMissing();
+            TextureArray* getArray();
+            int getLayer();
+            Texture* getAtlas();
+
+            // Maps coordinates within this image to coordinates within the texture it is drawn from.
+            vec2 getAtlasCoords(vec2 texCoords);
+
+            void setArray(TextureArray* array, int layer);
 
     };
 
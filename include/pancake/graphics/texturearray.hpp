@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include "pancake/graphics/texture.hpp"
+
+namespace Pancake {
+
+    // Textures of one size copied into the layers of an array texture, so a render batch can sample any
+    // number of them through a single texture unit.
+    class TextureArray {
+
+        private:
+
+            unsigned int id;
+            int width;
+            int height;
+            std::vector<Texture*> textures; // The texture in each layer, nullptr where the layer is free.
+
+            bool copy(Texture* texture, int layer, int x, int y, int width, int height);
+
+        public:
+
+            TextureArray(int width, int height, int layers);
+            ~TextureArray();
+
+            // Copies the texture into a free layer. Returns the layer, or -1 if there is no room or the copy failed.
+            int add(Texture* texture);
+            void remove(int layer);
+
+            // Copies a changed rectangle of a layer's texture again.
+            void update(int layer, int x, int y, int width, int height);
+
+            void bind();
+            void unbind();
+
+            unsigned int getId();
+            int getWidth();
+            int getHeight();
+            int getLayers();
+            bool isFull();
+
+            // The array holding the texture, copying it into one of its size with room if it is not in one yet.
+            // Returns nullptr for textures that can not be copied, and marks them as rejected.
+            static TextureArray* place(Texture* texture);
+
+            // Whether placing the texture has already failed. Unlike place, this never creates or copies anything.
+            static bool isRejected(Texture* texture);
+
+    };
+
+}
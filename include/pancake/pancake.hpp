@@ -19,6 +19,7 @@
 #include "pancake/core/engine.hpp"
 #include "pancake/core/entity.hpp"
 #include "pancake/core/listener.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/core/scene.hpp"
 #include "pancake/core/spatial.hpp"
 #include "pancake/core/window.hpp"
@@ -32,10 +33,16 @@
 #include "pancake/graphics/spriterenderer.hpp"
 #include "pancake/graphics/textrenderer.hpp"
 #include "pancake/graphics/texture.hpp"
+#include "pancake/graphics/texturearray.hpp"
 
+#include "pancake/physics/arbiter.hpp"
+#include "pancake/physics/bodies.hpp"
+#include "pancake/physics/broadphase.hpp"
 #include "pancake/physics/collider.hpp"
 #include "pancake/physics/collision.hpp"
+#include "pancake/physics/continuous.hpp"
 #include "pancake/physics/force.hpp"
+#include "pancake/physics/listener.hpp"
 #include "pancake/physics/raycast.hpp"
 #include "pancake/physics/rigidbody.hpp"
 #include "pancake/physics/world.hpp"
\ No newline at end of file
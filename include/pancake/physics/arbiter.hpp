@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "pancake/physics/collision.hpp"
+
+namespace Pancake {
+
+    class Rigidbody;
+    class BodyStore;
+
+    class Contact {
+
+        public:
+
+            CollisionManifold manifold;
+            int feature;            // Identifies the pair of colliders that produced the contact.
+
+            float normalImpulse;    // Accumulated over the step, and carried into the next step.
+            float tangentImpulse;
+            float normalMass;
+            float tangentMass;
+            float bias;
+
+            glm::vec2 rA;
+            glm::vec2 rB;
+
+            Contact();
+            Contact(CollisionManifold manifold, int feature);
+
+    };
+
+    // Holds the contacts between a pair of rigidbodies for as long as they keep touching, so the
+    // impulses found in one step can be used as the starting guess for the next.
+    class Arbiter {
+
+        private:
+
+            Rigidbody* a;
+            Rigidbody* b;
+            BodyStore* bodies;
+            std::vector<Contact> contacts;
+            std::vector<Contact> previous;
+            float friction;
+            float restitution;
+            int stamp;
+
+            // The slots of the rigidbodies in the body store, and their inverse masses, for the current step.
+            int bodyA;
+            int bodyB;
+            float inverseMassA;
+            float inverseMassB;
+            float inverseMomentA;
+            float inverseMomentB;
+
+            glm::vec2 relativeVelocity(const Contact& c);
+            void apply(const Contact& c, glm::vec2 impulse);
+
+        public:
+
+            Arbiter();
+            Arbiter(Rigidbody* a, Rigidbody* b, BodyStore* bodies);
+
+            Rigidbody* getA();
+            Rigidbody* getB();
+            std::vector<Contact>& getContacts();
+            int getStamp();
+            Arbiter* setStamp(int stamp);
+
+            // Replaces the contacts, keeping the accumulated impulses of contacts that persist.
+            void update(const Contact* contacts, int count);
+
+            void preStep();
+            void warmStart();
+            void applyImpulse();
+            void correctPositions();
+
+    };
+
+}
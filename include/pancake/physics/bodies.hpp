@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Pancake {
+
+    class Rigidbody;
+
+    // The state the integrator and solver work on, for every rigidbody in a world, kept in contiguous
+    // arrays indexed by the rigidbody's body index. Rigidbodies read and write their velocities and
+    // accumulators through the store while they are part of a world.
+    class BodyStore {
+
+        private:
+
+            std::vector<Rigidbody*> rigidbodies;
+            std::vector<unsigned char> massDirty; // Set when the inverse mass or moment needs to be refetched.
+
+        public:
+
+            std::vector<float> velocityX;
+            std::vector<float> velocityY;
+            std::vector<float> angularVelocity;
+            std::vector<float> forceX;
+            std::vector<float> forceY;
+            std::vector<float> torque;
+            std::vector<float> inverseMass;     // Zero for rigidbodies with infinite mass.
+            std::vector<float> inverseMoment;   // Zero for rigidbodies with infinite mass or a fixed orientation.
+
+            int size();
+            Rigidbody* get(int body);
+
+            // Appends the rigidbody, taking over its current state.
+            int add(Rigidbody* rigidbody);
+
+            // Hands the state back to the rigidbody, keeping the order of the remaining bodies.
+            void remove(int body);
+
+            glm::vec2 getVelocity(int body);
+            glm::vec2 getForce(int body);
+            void setVelocity(int body, glm::vec2 velocity);
+            void setForce(int body, glm::vec2 force);
+            void setMassDirty(int body);
+
+            // Refetches the inverse mass and moment of the rigidbodies whose colliders have changed.
+            void updateMasses();
+
+            // Applies the accumulated forces and torques to the velocities, and clears the accumulators.
+            void integrateForces(float dt);
+
+    };
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+#include "pancake/core/factory.hpp"
+#include "pancake/core/spatial.hpp"
+#include "pancake/core/tree.hpp"
+
+using json = nlohmann::json;
+
+namespace Pancake {
+
+    class Rigidbody;
+
+    class Broadphase {
+
+        private:
+
+            std::string type;
+
+        public:
+
+            Broadphase(std::string type);
+            virtual ~Broadphase();
+            virtual json serialise();
+            virtual bool load(json j);
+
+            std::string getType();
+
+            virtual void add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) = 0;
+            virtual void update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) = 0;
+            virtual void remove(Rigidbody* rigidbody) = 0;
+            virtual void clear() = 0;
+
+            // Appends every pair of rigidbodies whose bounds overlap to the result, each pair exactly once.
+            virtual void pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) = 0;
+
+            // Appends every rigidbody whose bounds overlap the region to the result.
+            virtual void query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) = 0;
+
+            // Calls back with every rigidbody whose bounds the ray passes through, up to the distance along it. The
+            // callback returns the distance beyond which no more rigidbodies are needed.
+            virtual void raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) = 0;
+
+            // Brings anything built lazily up to date, after which queries and raycasts only read and can be run
+            // from several threads at once.
+            virtual void prepare();
+
+    };
+
+    class SpatialHashBroadphase : public Broadphase {
+
+        private:
+
+            SpatialHashGrid<Rigidbody*>* grid;
+
+        public:
+
+            SpatialHashBroadphase();
+            ~SpatialHashBroadphase() override;
+            json serialise() override;
+            bool load(json j) override;
+
+            int getGridSize();
+            SpatialHashBroadphase* setGridSize(int gridSize);
+
+            void add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) override;
+            void update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) override;
+            void remove(Rigidbody* rigidbody) override;
+            void clear() override;
+            void pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) override;
+            void query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) override;
+            void raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) override;
+            void prepare() override;
+
+    };
+
+    REGISTER(Broadphase, SpatialHashBroadphase);
+
+    // Incremental sort and sweep along the x axis. The endpoint array persists between steps, so
+    // re-sorting a mostly coherent scene with insertion sort is close to linear.
+    class SweepAndPruneBroadphase : public Broadphase {
+
+        private:
+
+            struct Proxy {
+                Rigidbody* rigidbody;
+                glm::vec2 min;
+                glm::vec2 max;
+                int active;
+            };
+
+            struct Endpoint {
+                float value;
+                int proxy;
+                bool isMin;
+            };
+
+            std::vector<Proxy> proxies;
+            std::vector<int> freeProxies;
+            std::unordered_map<Rigidbody*, int> index;
+
+            std::vector<Endpoint> endpoints;
+            std::vector<int> activeProxies;
+            int sortedEndpoints;
+            bool removed;
+
+            void sort();
+
+        public:
+
+            SweepAndPruneBroadphase();
+
+            void add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) override;
+            void update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) override;
+            void remove(Rigidbody* rigidbody) override;
+            void clear() override;
+            void pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) override;
+            void query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) override;
+            void raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) override;
+
+    };
+
+    REGISTER(Broadphase, SweepAndPruneBroadphase);
+
+    class DynamicTreeBroadphase : public Broadphase {
+
+        private:
+
+            DynamicTree<Rigidbody*>* tree;
+
+        public:
+
+            DynamicTreeBroadphase();
+            ~DynamicTreeBroadphase() override;
+            json serialise() override;
+            bool load(json j) override;
+
+            float getMargin();
+            DynamicTreeBroadphase* setMargin(float margin);
+
+            void add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) override;
+            void update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) override;
+            void remove(Rigidbody* rigidbody) override;
+            void clear() override;
+            void pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) override;
+            void query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) override;
+            void raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) override;
+
+    };
+
+    REGISTER(Broadphase, DynamicTreeBroadphase);
+
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cmath>
 #include <string>
+#include <vector>
 #include <utility>
+#include <algorithm>
 #include <glm/glm.hpp>
 
 #include "pancake/core/component.hpp"
@@ -11,12 +14,26 @@ namespace Pancake {
 
     class Rigidbody;
 
+    // The shape of a collider, used to look up collision tests without casting.
+    enum ColliderShape {
+        BOX_COLLIDER = 0,
+        CIRCLE_COLLIDER = 1,
+        POLYGON_COLLIDER = 2,
+        CAPSULE_COLLIDER = 3,
+        TILEMAP_COLLIDER = 4,
+        COLLIDER_SHAPES = 5
+    };
+
+    // The most vertices a polygon collider can have.
+    const int MAX_POLYGON_VERTICES = 8;
+
     class Collider {
 
         private:
 
             Rigidbody* rigidbody;
             std::string type;
+            ColliderShape shape;
             float mass;
             glm::vec2 positionOffset;
             float rotationOffset;
@@ -25,12 +42,13 @@ namespace Pancake {
 
         public:
 
-            Collider(string type);
+            Collider(string type, ColliderShape shape);
             virtual ~Collider();
             virtual json serialise();
             virtual bool load(json j);
 
             std::string getType();
+            ColliderShape getShape();
             Rigidbody* getRigidbody();
             float getMass();
             virtual float getMomentOfInertia();
@@ -95,6 +113,152 @@ namespace Pancake {
 
     REGISTER(Collider, CircleCollider);
 
+    // A convex polygon, with its vertices kept in anticlockwise order around the collider's position.
+    class PolygonCollider : public Collider {
+
+        private:
+
+            std::vector<glm::vec2> vertices;
+
+            bool buildHull(std::vector<glm::vec2> vertices);
+
+        public:
+
+            PolygonCollider();
+            json serialise() override;
+            bool load(json j) override;
+
+            float getMomentOfInertia() override;
+            std::pair<glm::vec2, glm::vec2> getLocalBounds() override;
+            std::vector<glm::vec2> getVertices();
+
+            // Takes the convex hull of the vertices, which needs between 3 and MAX_POLYGON_VERTICES corners.
+            // A hull that is degenerate or has too many corners is rejected and the vertices are left as they were.
+            PolygonCollider* setVertices(std::vector<glm::vec2> vertices);
+
+    };
+
+    REGISTER(Collider, PolygonCollider);
+
+    // A line segment along the collider's x axis with a rounded skin, the two ends being semicircles.
+    class CapsuleCollider : public Collider {
+
+        private:
+
+            float length;   // The distance between the centres of the two ends.
+            float radius;
+
+        public:
+
+            CapsuleCollider();
+            json serialise() override;
+            bool load(json j) override;
+
+            float getMomentOfInertia() override;
+            std::pair<glm::vec2, glm::vec2> getLocalBounds() override;
+            float getLength();
+            float getRadius();
+
+            CapsuleCollider* setLength(float length);
+            CapsuleCollider* setRadius(float radius);
+
+    };
+
+    REGISTER(Collider, CapsuleCollider);
+
+    // A static grid of solid tiles, with tile (0, 0) in the bottom left corner at the collider's position. The solid
+    // tiles are merged into as few boxes as a greedy pass finds, and only the boxes near another collider are tested
+    // against it. Tilemaps do not rotate, and one whose rigidbody has been rotated is never hit.
+    class TilemapCollider : public Collider {
+
+        private:
+
+            // A merged box, in tiles.
+            struct Rectangle {
+                int x;
+                int y;
+                int width;
+                int height;
+            };
+
+            int width;
+            int height;
+            glm::vec2 tileSize;
+            std::vector<unsigned char> tiles;   // Row by row from the bottom, non zero if solid.
+
+            // The boxes are rebuilt lazily when the bounds are next read, which the world does before any collisions.
+            std::vector<Rectangle> rectangles;
+            std::vector<BoxCollider*> boxes;
+            std::vector<int> owners;            // The box covering each tile, or -1 if it is empty.
+            Rigidbody* builtFor;
+            glm::vec2 builtOffset;
+            bool dirty;
+
+            void rebuild();
+            void setDirty();
+            bool isBuilt();
+
+        public:
+
+            TilemapCollider();
+            ~TilemapCollider() override;
+            json serialise() override;
+            bool load(json j) override;
+
+            float getMomentOfInertia() override;
+            std::pair<glm::vec2, glm::vec2> getLocalBounds() override;
+            int getWidth();
+            int getHeight();
+            glm::vec2 getTileSize();
+            bool isSolid(int x, int y);
+            int getBoxCount();
+            BoxCollider* getBox(int index);
+
+            TilemapCollider* setSize(int width, int height);
+            TilemapCollider* setTileSize(glm::vec2 size);
+            TilemapCollider* setTileSize(float w, float h);
+            TilemapCollider* setSolid(int x, int y, bool solid);
+
+            // Rebuilds the boxes if the map has changed, so that queries after it only read them.
+            void prepare();
+
+            // Calls back with every box that overlaps the region, and its index, once each. Nothing is reported
+            // if the boxes are out of date with the map, or if the tilemap has been rotated.
+            template<class F>
+            void query(glm::vec2 min, glm::vec2 max, F callback) {
+
+                if (!this->isBuilt() || this->getRotation() != 0.0f) {return;}
+
+                // Find the range of tiles the region covers, clamped to the map.
+                glm::vec2 origin = this->getPosition();
+                glm::vec2 low = (min - origin) / this->tileSize;
+                glm::vec2 high = (max - origin) / this->tileSize;
+                if (high.x < 0.0f || high.y < 0.0f || low.x >= this->width || low.y >= this->height) {return;}
+                int xMin = std::max((int) std::floor(low.x), 0);
+                int yMin = std::max((int) std::floor(low.y), 0);
+                int xMax = std::min((int) std::floor(high.x), this->width - 1);
+                int yMax = std::min((int) std::floor(high.y), this->height - 1);
+
+                for (int y = yMin; y <= yMax; y++) {
+                    for (int x = xMin; x <= xMax; x++) {
+
+                        int box = this->owners[y * this->width + x];
+                        if (box == -1) {continue;}
+
+                        // Report each box from the first tile of the region it covers.
+                        const Rectangle& r = this->rectangles[box];
+                        if (std::max(r.x, xMin) != x || std::max(r.y, yMin) != y) {continue;}
+                        callback(this->boxes[box], box);
+
+                    }
+                }
+
+            }
+
+    };
+
+    REGISTER(Collider, TilemapCollider);
+
 }
 
 #include "pancake/physics/rigidbody.hpp"
\ No newline at end of file
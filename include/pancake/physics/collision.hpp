@@ -23,8 +23,87 @@ namespace Pancake {
 
     };
 
+    // Any collider as a convex polygon in world space with a rounded skin around it. A circle is a single
+    // vertex and a capsule a single edge, each skinned by their radius, while boxes and polygons have none.
+    class RoundedPolygon {
+
+        public:
+
+            vec2 vertices[MAX_POLYGON_VERTICES];
+            vec2 normals[MAX_POLYGON_VERTICES];     // The outward normal of the edge from each vertex to the next.
+            int count;
+            float radius;
+
+            RoundedPolygon(Collider* collider, vec2 offset);
+            RoundedPolygon(vec2 centre, float radius);
+            RoundedPolygon(vec2 centre, vec2 size, float rotation);
+            RoundedPolygon translate(vec2 offset) const;
+
+    };
+
+    // Circle against circle pairs, packed into parallel arrays so they can be tested several at a time.
+    class CirclePairs {
+
+        public:
+
+            std::vector<float> aX;
+            std::vector<float> aY;
+            std::vector<float> aRadius;
+            std::vector<float> bX;
+            std::vector<float> bY;
+            std::vector<float> bRadius;
+
+            int size();
+            void clear();
+            void add(CircleCollider* a, CircleCollider* b);
+
+    };
+
+    // Circle against box pairs, packed the same way. The box rotation is stored as the cosine and sine
+    // that take the circle into the box's space.
+    class CircleBoxPairs {
+
+        public:
+
+            std::vector<float> circleX;
+            std::vector<float> circleY;
+            std::vector<float> radius;
+            std::vector<float> boxX;
+            std::vector<float> boxY;
+            std::vector<float> halfWidth;
+            std::vector<float> halfHeight;
+            std::vector<float> cos;
+            std::vector<float> sin;
+            std::vector<float> sign;    // -1 when the box came first, so the normal points from the box.
+
+            int size();
+            void clear();
+            void add(CircleCollider* c, BoxCollider* b, bool flip);
+
+    };
+
     namespace Collision {
+
+        // The most manifolds a single pair of colliders can produce.
+        const int MAX_MANIFOLDS = 2;
+
         std::vector<CollisionManifold> findCollisionFeatures(Collider* c1, Collider* c2);
+
+        // Writes the manifolds of a pair of colliders into result, which needs room for MAX_MANIFOLDS, and
+        // returns how many were written. Tilemaps are not tested here, only the boxes they are made of.
+        int findCollisionFeatures(Collider* c1, Collider* c2, CollisionManifold* result);
+
+        // The distance between two colliders, with the first moved by the offset, and the direction from the
+        // first to the second. Overlapping colliders give the negative depth along the shallowest face. Tilemaps
+        // are not measured here either.
+        float findDistance(Collider* c1, vec2 offset, Collider* c2, vec2& normal);
+        float findDistance(const RoundedPolygon& a, const RoundedPolygon& b, vec2& normal);
+
+        // Tests every packed pair, writing one manifold per pair and whether the pair is colliding. Both
+        // outputs need room for every pair, and the manifolds of pairs that are not colliding are unset.
+        void findCollisionFeatures(CirclePairs& pairs, CollisionManifold* manifolds, unsigned char* hits);
+        void findCollisionFeatures(CircleBoxPairs& pairs, CollisionManifold* manifolds, unsigned char* hits);
+
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "pancake/physics/collider.hpp"
+#include "pancake/physics/collision.hpp"
+
+using glm::vec2;
+
+namespace Pancake {
+
+    class TimeOfImpact {
+
+        public:
+
+            bool hit;
+            float time;     // The fraction of the displacement that can be covered before touching.
+            vec2 normal;    // Points from the moving collider to the one it hits.
+
+            TimeOfImpact();
+            TimeOfImpact(float time, vec2 normal);
+
+    };
+
+    namespace Continuous {
+
+        // Finds how far the first collider can move along the displacement before touching the second,
+        // which is treated as still. Only the translation is swept, the orientation is kept as it is.
+        // Pairs that are already touching at the start are an impact at time 0 if they are closing, and
+        // are left to the discrete solver if they are separating.
+        TimeOfImpact findTimeOfImpact(Collider* c1, vec2 displacement, Collider* c2);
+
+        // The same for a shape that is not attached to anything, such as one swept by a query. A shape that
+        // starts touching or overlapping the collider always hits it at time 0, with the normal to separate them.
+        TimeOfImpact findTimeOfImpact(const RoundedPolygon& shape, vec2 displacement, Collider* c2);
+
+    }
+
+}
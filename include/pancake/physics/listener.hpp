@@ -0,0 +1,26 @@
+#pragma once
+
+#include "pancake/physics/collision.hpp"
+
+namespace Pancake {
+
+    class Entity;
+
+    // Components that also derive from this are told about the collisions of their entity's rigidbody.
+    // Each pair of rigidbodies is reported once per step, after the step has been solved.
+    class CollisionListener {
+
+        public:
+
+            // When the rigidbodies start touching.
+            virtual void beginCollision(Entity* with, CollisionManifold manifold) {}
+
+            // Every step the rigidbodies are touching and awake, including the first, with the deepest contact between them.
+            virtual void collision(Entity* with, CollisionManifold manifold) {}
+
+            // When the rigidbodies stop touching, or the other one leaves the world.
+            virtual void endCollision(Entity* with) {}
+
+    };
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include <glm/glm.hpp>
 #include "pancake/physics/rigidbody.hpp"
 
@@ -13,8 +14,11 @@ namespace Pancake {
 
             vec2 origin;
             vec2 direction;
+            float distance;     // How far along the direction the ray reaches.
+            unsigned int mask;  // The layers the ray can hit.
 
             Ray(vec2 origin, vec2 direction);
+            Ray(vec2 origin, vec2 direction, float distance);
             void rotate(vec2 around, float rCos, float rSin);
 
     };
@@ -33,8 +37,34 @@ namespace Pancake {
             
     };
 
+    // Which hits a query reports for each ray.
+    enum RaycastMode {
+        RAYCAST_CLOSEST = 0,    // The nearest hit.
+        RAYCAST_ANY = 1,        // Whichever hit is found first, which is all a line of sight check needs.
+        RAYCAST_ALL = 2         // Every rigidbody hit, nearest first.
+    };
+
+    // The hits of a batch of queries. The hits of query i are hits[starts[i]] up to hits[starts[i + 1]].
+    class RaycastHits {
+
+        public:
+
+            std::vector<RaycastResult> hits;
+            std::vector<int> starts;
+
+            void clear();
+            int size();
+            int count(int query);
+            RaycastResult get(int query, int hit);
+
+    };
+
     namespace Raycast {
+
+        // The nearest collider of the rigidbody that the ray hits. Colliders that the ray starts inside are not hit,
+        // and the normal is the surface normal where the ray enters.
         RaycastResult raycast(Rigidbody* rigidbody, Ray ray);
+
     }
 
 }
\ No newline at end of file
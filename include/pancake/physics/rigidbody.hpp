@@ -11,6 +11,10 @@
 namespace Pancake {
 
     class Collider;
+    class BodyStore;
+
+    // A mask that includes every layer.
+    const unsigned int ALL_LAYERS = 0xFFFFFFFF;
 
     class Rigidbody : public Component {
 
@@ -42,6 +46,19 @@ namespace Pancake {
             bool sensor;
             bool infiniteMass;
             bool fixedOrientation;
+            bool continuous;  // Swept through each step so it cannot pass through thin colliders.
+
+            unsigned int layers;    // The layers the rigidbody is on.
+            unsigned int mask;      // The layers the rigidbody collides with.
+
+            bool awake;
+            bool sleepingAllowed;
+            float sleepTime;  // How long the rigidbody has been slow enough to sleep.
+
+            // While the rigidbody is in a world, its velocities and accumulators live in the world's body
+            // store instead of the fields above.
+            BodyStore* bodies;
+            int body;
 
         public:
 
@@ -52,10 +69,14 @@ namespace Pancake {
             bool load(json j) override;
 
             std::vector<Collider*> getColliders();
+            Collider* getCollider(int index);
+            int getColliderCount();
             std::unordered_set<std::string> getForceGenerators();
+            glm::vec2 getForce();
             glm::vec2 getVelocity();
             glm::vec2 getCentroid();
             std::pair<glm::vec2, glm::vec2> getBounds();
+            float getTorque();
             float getAngularVelocity();
             float getRestitution();
             float getFriction();
@@ -64,9 +85,18 @@ namespace Pancake {
             float getMomentOfInertia();
             float getInverseMomentOfInertia();
             bool isSensor();
+            bool isBoundsDirty();
             bool hasForceGenerator(std::string type);
             bool hasFixedOrientation();
+            bool isContinuous();
             bool hasInfiniteMass();
+            unsigned int getLayers();
+            unsigned int getMask();
+            bool canCollide(Rigidbody* other);
+            bool isAwake();
+            bool isSleepingAllowed();
+            float getSleepTime();
+            int getBody();
 
             Rigidbody* addCollider(Collider* collider);
             Rigidbody* addColliders(std::vector<Collider*> colliders);
@@ -94,12 +124,21 @@ namespace Pancake {
             Rigidbody* setFriction(float cof);
             Rigidbody* setSensor(bool sensor);
             Rigidbody* setFixedOrientation(bool orientation);
+            Rigidbody* setContinuous(bool continuous);
+            Rigidbody* setLayers(unsigned int layers);
+            Rigidbody* setMask(unsigned int mask);
             Rigidbody* setCentroidDirty();
             Rigidbody* setBoundsDirty();
             Rigidbody* setMassDirty();
             Rigidbody* setMomentDirty();
+            Rigidbody* setAwake(bool awake);
+            Rigidbody* setSleepingAllowed(bool allowed);
+            Rigidbody* setBody(BodyStore* bodies, int body);
 
             void physicsUpdate(float dt);
+            void integrateForces(float dt);
+            void integrateVelocity(float dt);
+            void updateSleepTime(float dt, float linearTolerance, float angularTolerance);
 
             void clearAccumulators();
             void addVelocity(glm::vec2 velocity);
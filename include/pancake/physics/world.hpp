@@ -7,15 +7,32 @@
 #include <unordered_set>
 #include <nlohmann/json.hpp>
 
+#include "pancake/core/jobs.hpp"
 #include "pancake/core/spatial.hpp"
+#include "pancake/physics/bodies.hpp"
+#include "pancake/physics/arbiter.hpp"
+#include "pancake/physics/broadphase.hpp"
+#include "pancake/physics/continuous.hpp"
 #include "pancake/physics/force.hpp"
 #include "pancake/physics/collision.hpp"
+#include "pancake/physics/listener.hpp"
 #include "pancake/physics/raycast.hpp"
 
 namespace Pancake {
 
-    class CollisionListener {
-        public: virtual void collision(Entity* with, CollisionManifold manifold) {}
+    // How long each phase of the last step took, in milliseconds.
+    class StepTimings {
+
+        public:
+
+            double integrate;       // Forces, velocities and positions, including continuous sweeps.
+            double broadphase;      // Updating the broadphase, and finding and filtering the pairs.
+            double narrowphase;     // Testing the pairs and updating their arbiters.
+            double solve;           // Islands, impulses, position correction and sleeping.
+            double total;           // The whole step, including reporting collisions to listeners.
+
+            StepTimings();
+
     };
 
     class World {
@@ -29,13 +46,97 @@ namespace Pancake {
 
             std::vector<Rigidbody*> rigidbodies;
             std::unordered_set<Rigidbody*> rigidbodiesIndex;
-
-            SpatialHashGrid<Rigidbody*>* grid;
+            BodyStore bodies;                   // In the same order as the rigidbodies.
+
+            Broadphase* broadphase;
+            std::vector<std::pair<Rigidbody*, Rigidbody*>> candidates;
+            std::vector<Rigidbody*> sweep;      // Rigidbodies near the path of a continuous rigidbody.
+
+            std::unordered_map<std::pair<int, int>, Arbiter, IntPairHash, IntPairEqual> arbiters; // Keyed by the rigidbody ids, smallest first.
+            std::vector<Arbiter*> active;
+            int step;
+            bool deterministic;
+
+            // A pair of rigidbodies with listeners that were touching, and the last step they were.
+            struct Touch {
+                Rigidbody* a;
+                Rigidbody* b;
+                int stamp;
+            };
+
+            enum CollisionEventKind {
+                COLLISION_BEGIN = 0,
+                COLLISION_STAY = 1,
+                COLLISION_END = 2
+            };
+
+            // A collision waiting to be reported to the listeners once the step is over.
+            struct CollisionEvent {
+                Rigidbody* a;
+                Rigidbody* b;
+                CollisionManifold manifold;
+                CollisionEventKind kind;
+            };
+
+            std::unordered_map<std::pair<int, int>, Touch, IntPairHash, IntPairEqual> touching; // Keyed like the arbiters.
+            std::vector<CollisionEvent> events;
+
+            // How a candidate pair is tested by the narrowphase.
+            enum PairKind {
+                PAIR_COLLIDERS = 0,     // Every pairing of colliders, one at a time.
+                PAIR_CIRCLES = 1,       // A single circle each, tested in a packed batch.
+                PAIR_CIRCLE_BOX = 2     // A single circle and box, tested in a packed batch.
+            };
+
+            // The contacts found by one batch of the narrowphase, and where each candidate's contacts end.
+            struct NarrowphaseBuffer {
+                std::vector<Contact> contacts;
+                std::vector<int> ends;
+                std::vector<unsigned char> kinds;
+                std::vector<int> slots;             // Where each packed candidate is in its batch.
+                CirclePairs circles;
+                CircleBoxPairs circleBoxes;
+                std::vector<CollisionManifold> circleManifolds;
+                std::vector<CollisionManifold> circleBoxManifolds;
+                std::vector<unsigned char> circleHits;
+                std::vector<unsigned char> circleBoxHits;
+            };
+
+            // The rigidbodies near one batch of queries, and the hits the batch found.
+            struct QueryBuffer {
+                std::vector<Rigidbody*> nearby;
+                std::vector<RaycastResult> hits;
+            };
+
+            JobPool* jobs;
+            std::vector<NarrowphaseBuffer> narrowphase;
+            std::vector<QueryBuffer> queries;
+            std::vector<std::vector<Arbiter*>> colours;      // Arbiters that share no dynamic rigidbody.
+            std::vector<unsigned long long> colourMasks;     // The colours used by each rigidbody, indexed by rigidbody.
+
+            std::vector<int> islands;           // Union-find parents, indexed by rigidbody.
+            std::vector<bool> islandsAwake;
+            std::vector<float> islandSleepTimes;
 
             float timeStep;
             float time;
+            StepTimings timings;
 
             void fixedUpdate();
+            void updateBroadphase();
+            float findReach(Rigidbody* rigidbody);
+            void advance(Rigidbody* rigidbody, float reach);
+            void pack(Rigidbody* a, Rigidbody* b, NarrowphaseBuffer& buffer);
+            void collide(Rigidbody* a, Rigidbody* b, std::vector<Contact>& result);
+            void touch(Rigidbody* a, Rigidbody* b, const Contact* contacts, int count);
+            void dispatch();
+            void colourArbiters();
+            void solve(void (Arbiter::*method)());
+            int findIsland(int rigidbody);
+            void buildIslands();
+            void sleepIslands();
+            void cast(const Ray& ray, const RoundedPolygon* shape, RaycastMode mode, std::vector<Rigidbody*>& nearby, std::vector<RaycastResult>& result);
+            void cast(const std::vector<Ray>& rays, const RoundedPolygon* shape, RaycastMode mode, RaycastHits& result);
 
         public:
 
@@ -56,9 +157,33 @@ namespace Pancake {
             void addForceRegistration(std::string force, Rigidbody* rigidbody);
             void removeForceRegistration(std::string force, Rigidbody* rigidbody);
 
-            SpatialHashGrid<Rigidbody*>* getGrid();
+            int getThreadCount();
+            void setThreadCount(int threads);
+
+            // A deterministic world works through pairs and contacts in rigidbody id order, and solves the same
+            // way for any number of threads. Given the same rigidbodies, added in the same order, and the same
+            // updates, it steps bit for bit the same on the same build.
+            bool isDeterministic();
+            void setDeterministic(bool deterministic);
+
+            // A hash of the state of every rigidbody, for checking that two runs have not diverged.
+            unsigned long long getChecksum();
+            StepTimings getTimings();
+
+            Broadphase* getBroadphase();
+            void setBroadphase(Broadphase* broadphase);
             RaycastResult raycast(Ray ray);
 
+            // Queries run across the world's threads, and see the rigidbodies where they were at the end of the last step.
+            void raycast(const std::vector<Ray>& rays, RaycastMode mode, RaycastHits& result);
+
+            // Sweep a circle, or a box, centred on the origin of each ray along it. Every ray needs a distance, or
+            // the whole batch is rejected with no hits. The point of each hit is where the centre of the shape stops.
+            void circlecast(const std::vector<Ray>& rays, float radius, RaycastMode mode, RaycastHits& result);
+            void boxcast(const std::vector<Ray>& rays, glm::vec2 size, float rotation, RaycastMode mode, RaycastHits& result);
+            std::vector<Rigidbody*> query(glm::vec2 min, glm::vec2 max);
+            std::vector<Rigidbody*> query(glm::vec2 min, glm::vec2 max, unsigned int mask);
+
     };
 
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #include <tuple>
+#include <vector>
 #include <utility>
 #include <iostream>
 #include <unordered_map>
+#include <stb/stb_image.h>
 #include "pancake/asset/assetpool.hpp"
 #include "pancake/asset/spritesheet.hpp"
+#include "pancake/asset/atlas.hpp"
 
 namespace Pancake {
 
@@ -22,6 +25,13 @@ namespace Pancake {
         };
 
         const float DEFAULT_FONT_SIZE = 64;
+
+        // Images up to this size are packed into atlases, larger ones would fill them too quickly.
+        const int ATLAS_SIZE = 2048;
+        const int ATLAS_MAX_IMAGE_SIZE = 256;
+
+        bool atlasing = false;
+        std::vector<Atlas*> atlases;
         std::unordered_map<std::string, Texture*> textures;
         std::unordered_map<std::string, Sprite*> sprites;
         std::unordered_map<std::tuple<std::string, float>, Font*, TupleHash, TupleEqual> fonts;
@@ -70,6 +80,8 @@ namespace Pancake {
             delete t;
         }
         textures.clear();
+        for (Atlas* atlas : atlases) {delete atlas;}
+        atlases.clear();
     }
 
     Texture* TexturePool::get(std::string name) {
@@ -78,6 +90,39 @@ namespace Pancake {
         auto search = textures.find(name);
         if (search != textures.end()) {return search->second;}
 
+        // Pack small images into an atlas, checking the size before loading the whole image.
+        int width;
+        int height;
+        int channels;
+        if (atlasing && stbi_info(name.c_str(), &width, &height, &channels) && width <= ATLAS_MAX_IMAGE_SIZE && height <= ATLAS_MAX_IMAGE_SIZE) {
+
+            stbi_set_flip_vertically_on_load(1);
+            unsigned char* image = stbi_load(name.c_str(), &width, &height, &channels, 4);
+
+            if (image != nullptr) {
+
+                Texture* texture = nullptr;
+                for (Atlas* atlas : atlases) {
+                    texture = atlas->add(name, image, width, height);
+                    if (texture != nullptr) {break;}
+                }
+
+                // Start a new atlas once the others are full.
+                if (texture == nullptr) {
+                    atlases.push_back(new Atlas(ATLAS_SIZE, ATLAS_SIZE));
+                    texture = atlases.back()->add(name, image, width, height);
+                }
+
+                stbi_image_free(image);
+                if (texture != nullptr) {
+                    textures.insert(std::pair<std::string, Texture*>(name, texture));
+                    return texture;
+                }
+
+            }
+
+        }
+
         // Initialise the texture. If the texture fails to initialise a missing texture will be generated.
         Texture* texture = new Texture(name);
         std::pair<std::string, Texture*> p(texture->getName(), texture);
@@ -86,6 +131,14 @@ namespace Pancake {
 
     }
 
+    bool TexturePool::isAtlasing() {
+        return atlasing;
+    }
+
+    void TexturePool::setAtlasing(bool state) {
+        atlasing = state;
+    }
+
     void SpritePool::init() {
 
         // Add the empty sprite to the pool
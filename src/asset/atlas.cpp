@@ -0,0 +1,126 @@
+#include <vector>
+#include <algorithm>
+#include <glad/glad.h>
+#include "pancake/asset/atlas.hpp"
+
+namespace Pancake {
+
+    namespace {
+
+        // Each image is surrounded by copies of its edge pixels, so sampling at its border never reads a neighbour.
+        const int PADDING = 2;
+
+    }
+
+    Atlas::Atlas(int width, int height) {
+        this->width = width;
+        this->height = height;
+        this->texture = new Texture(GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+        this->skyline.push_back({0, 0, width});
+    }
+
+    Atlas::~Atlas() {
+        delete this->texture;
+    }
+
+    int Atlas::fit(int index, int width, int height) {
+
+        // The lowest height a rectangle can sit at with its left edge on this skyline segment, or -1 if it does not fit.
+        int x = this->skyline[index].x;
+        if (x + width > this->width) {return -1;}
+
+        int y = 0;
+        int remaining = width;
+        for (int i = index; remaining > 0; i++) {
+            y = std::max(y, this->skyline[i].y);
+            if (y + height > this->height) {return -1;}
+            remaining -= this->skyline[i].width;
+        }
+
+        return y;
+
+    }
+
+    bool Atlas::pack(int width, int height, int& x, int& y) {
+
+        // Place the rectangle where its top is lowest, preferring narrower segments to leave less wasted space.
+        int best = -1;
+        int bestTop = this->height + 1;
+        int bestWidth = this->width + 1;
+        for (int i = 0; i < this->skyline.size(); i++) {
+            int current = this->fit(i, width, height);
+            if (current == -1) {continue;}
+            if (current + height < bestTop || (current + height == bestTop && this->skyline[i].width < bestWidth)) {
+                best = i;
+                bestTop = current + height;
+                bestWidth = this->skyline[i].width;
+                y = current;
+            }
+        }
+
+        if (best == -1) {return false;}
+        x = this->skyline[best].x;
+
+        // Raise the skyline under the rectangle, trimming or removing the segments it covers.
+        this->skyline.insert(this->skyline.begin() + best, {x, y + height, width});
+        for (int i = best + 1; i < this->skyline.size(); i++) {
+            int covered = this->skyline[i-1].x + this->skyline[i-1].width - this->skyline[i].x;
+            if (covered <= 0) {break;}
+            this->skyline[i].x += covered;
+            this->skyline[i].width -= covered;
+            if (this->skyline[i].width > 0) {break;}
+            this->skyline.erase(this->skyline.begin() + i);
+            i--;
+        }
+
+        // Merge neighbouring segments at the same height.
+        for (int i = 1; i < this->skyline.size(); i++) {
+            if (this->skyline[i-1].y == this->skyline[i].y) {
+                this->skyline[i-1].width += this->skyline[i].width;
+                this->skyline.erase(this->skyline.begin() + i);
+                i--;
+            }
+        }
+
+        return true;
+
+    }
+
+    Texture* Atlas::add(std::string name, unsigned char* image, int width, int height) {
+
+        int paddedWidth = width + 2 * PADDING;
+        int paddedHeight = height + 2 * PADDING;
+        int x;
+        int y;
+        if (!this->pack(paddedWidth, paddedHeight, x, y)) {return nullptr;}
+
+        // Copy the image into the middle of the padded rectangle, bleeding its edges out into the padding.
+        std::vector<unsigned char> padded(paddedWidth * paddedHeight * 4);
+        for (int j = 0; j < paddedHeight; j++) {
+            int sourceY = std::min(std::max(j - PADDING, 0), height - 1);
+            for (int i = 0; i < paddedWidth; i++) {
+                int sourceX = std::min(std::max(i - PADDING, 0), width - 1);
+                for (int c = 0; c < 4; c++) {padded[(j * paddedWidth + i) * 4 + c] = image[(sourceY * width + sourceX) * 4 + c];}
+            }
+        }
+        this->texture->update(x, y, paddedWidth, paddedHeight, padded.data());
+
+        vec2 regionMin = vec2((float) (x + PADDING) / this->width, (float) (y + PADDING) / this->height);
+        vec2 regionMax = vec2((float) (x + PADDING + width) / this->width, (float) (y + PADDING + height) / this->height);
+        return new Texture(name, this->texture, regionMin, regionMax, width, height);
+
+    }
+
+    Texture* Atlas::getTexture() {
+        return this->texture;
+    }
+
+    int Atlas::getWidth() {
+        return this->width;
+    }
+
+    int Atlas::getHeight() {
+        return this->height;
+    }
+
+}
@@ -1,4 +1,5 @@
 #include "pancake/core/console.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/core/window.hpp"
 #include <imgui.h>
 #include <vector>
@@ -17,8 +18,13 @@ namespace Pancake {
 
         void parse(const char* command) {
 
-            if (strcmp(command, "help") == 0) {output.push_back("Available commands: help, quit");}
+            if (strcmp(command, "help") == 0) {output.push_back("Available commands: help, quit, profile, trace <filename>");}
             else if (strcmp(command, "quit") == 0) {Window::stop();}
+            else if (strcmp(command, "profile") == 0) {Profiler::toggle();}
+            else if (strncmp(command, "trace ", 6) == 0) {
+                if (Profiler::save(command + 6)) {output.push_back("Saved the last " + std::to_string(Profiler::getFrameCount()) + " frames to " + string(command + 6));}
+                else {output.push_back("Could not save the trace.");}
+            }
             else {output.push_back("Unknown command. Type 'help' for a list of available commands.");}
 
         }
@@ -44,6 +50,9 @@ namespace Pancake {
         }
 
         void render() {
+
+            // The profiler overlay can stay open while the terminal is closed.
+            Profiler::render();
             
             // If not active, don't render the terminal.
             if (!active) {return;}
@@ -7,6 +7,7 @@
 #include "pancake/core/entity.hpp"
 #include "pancake/core/component.hpp"
 #include "pancake/core/factory.hpp"
+#include "pancake/physics/listener.hpp"
 #include <pancake/core/window.hpp>
 
 namespace Pancake {
@@ -88,6 +89,8 @@ namespace Pancake {
         for (int i : dead) {
             Component* c = this->components[i];
             this->components.erase(this->components.begin() + i);
+            CollisionListener* listener = dynamic_cast<CollisionListener*>(c);
+            if (listener != nullptr) {this->listeners.erase(std::find(this->listeners.begin(), this->listeners.end(), listener));}
             Window::getScene()->getComponents()->erase(c->getId());
             delete c;
         }
@@ -203,6 +206,10 @@ namespace Pancake {
         return this->components;
     }
 
+    const std::vector<CollisionListener*>& Entity::getCollisionListeners() {
+        return this->listeners;
+    }
+
     glm::vec2 Entity::getPosition() {
         return this->position;
     }
@@ -215,6 +222,13 @@ namespace Pancake {
         return this->rotation;
     }
 
+    std::pair<glm::vec2, glm::vec2> Entity::getBounds() {
+        float c = fabsf(cosf(this->rotation));
+        float s = fabsf(sinf(this->rotation));
+        glm::vec2 half = 0.5f * glm::vec2(c * this->size.x + s * this->size.y, s * this->size.x + c * this->size.y);
+        return std::make_pair(this->position - half, this->position + half);
+    }
+
     bool Entity::isSerialisable() {
         return this->serialisable;
     }
@@ -321,6 +335,8 @@ namespace Pancake {
     void Entity::addComponent(Component* component) {
         component->setEntity(this);
         this->components.push_back(component);
+        CollisionListener* listener = dynamic_cast<CollisionListener*>(component);
+        if (listener != nullptr) {this->listeners.push_back(listener);}
         if (this->started) {
             Window::getScene()->getComponents()->insert({component->getId(), component});
             component->start();
@@ -0,0 +1,92 @@
+#include "pancake/core/jobs.hpp"
+
+namespace Pancake {
+
+    JobPool::JobPool(int threads) {
+
+        this->next = 0;
+        this->jobs = 0;
+        this->busy = 0;
+        this->batch = 0;
+        this->stopping = false;
+
+        for (int i = 1; i < threads; i++) {
+            this->workers.push_back(std::thread(&JobPool::work, this));
+        }
+
+    }
+
+    JobPool::~JobPool() {
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+
+        this->started.notify_all();
+        for (std::thread& worker : this->workers) {worker.join();}
+
+    }
+
+    int JobPool::getThreadCount() {
+        return this->workers.size() + 1;
+    }
+
+    void JobPool::run(int jobs, std::function<void(int)> job) {
+
+        // Small batches are not worth waking the workers for.
+        if (this->workers.empty() || jobs <= 1) {
+            for (int i = 0; i < jobs; i++) {job(i);}
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->job = job;
+            this->jobs = jobs;
+            this->next = 0;
+            this->busy = this->workers.size();
+            this->batch++;
+        }
+
+        this->started.notify_all();
+        this->drain();
+
+        // Wait for the workers to finish the jobs they picked up.
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->finished.wait(lock, [this] {return this->busy == 0;});
+        this->job = nullptr;
+
+    }
+
+    void JobPool::work() {
+
+        int batch = 0;
+        while (true) {
+
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->started.wait(lock, [this, batch] {return this->stopping || this->batch != batch;});
+                if (this->stopping) {return;}
+                batch = this->batch;
+            }
+
+            this->drain();
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->busy--;
+            if (this->busy == 0) {this->finished.notify_one();}
+
+        }
+
+    }
+
+    void JobPool::drain() {
+        int i = this->next++;
+        while (i < this->jobs) {
+            this->job(i);
+            i = this->next++;
+        }
+    }
+
+}
@@ -0,0 +1,212 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+
+#include "pancake/core/profiler.hpp"
+
+namespace Pancake {
+
+    namespace {
+
+        typedef std::chrono::steady_clock Clock;
+
+        bool enabled = true;
+        bool active = false;
+        // Read from any thread that runs instrumented code, but only written by the one that begins frames.
+        std::atomic<bool> recording(false);
+        std::atomic<std::thread::id> thread;
+        Clock::time_point epoch = Clock::now();
+
+        // The frames are a ring buffer, their sample vectors are kept so recording does not allocate once warm.
+        ProfileFrame frames[Profiler::FRAMES];
+        int next = 0;
+        int kept = 0;
+        std::vector<int> unfinished; // The samples of the current frame whose zones have not ended.
+
+        double now() {
+            return std::chrono::duration<double, std::micro>(Clock::now() - epoch).count();
+        }
+
+        bool recordable() {
+            return recording && std::this_thread::get_id() == thread;
+        }
+
+        // A complete event in the Chrome trace format, everything runs on the one thread.
+        nlohmann::json event(const char* name, double start, double duration) {
+            nlohmann::json j;
+            j.emplace("name", name);
+            j.emplace("ph", "X");
+            j.emplace("ts", start);
+            j.emplace("dur", duration);
+            j.emplace("pid", 1);
+            j.emplace("tid", 1);
+            return j;
+        }
+
+        nlohmann::json counter(const char* name, double start, double value) {
+            nlohmann::json args;
+            args.emplace("value", value);
+            nlohmann::json j;
+            j.emplace("name", name);
+            j.emplace("ph", "C");
+            j.emplace("ts", start);
+            j.emplace("args", args);
+            j.emplace("pid", 1);
+            return j;
+        }
+
+    }
+
+    namespace Profiler {
+
+        void beginFrame() {
+            if (!enabled) {return;}
+            ProfileFrame& frame = frames[next];
+            frame.samples.clear();
+            frame.counters.clear();
+            frame.start = now();
+            frame.duration = 0.0;
+            unfinished.clear();
+            thread = std::this_thread::get_id();
+            recording = true;
+        }
+
+        void endFrame() {
+
+            if (!recording) {return;}
+            ProfileFrame& frame = frames[next];
+            double end = now();
+            frame.duration = end - frame.start;
+
+            // Close any zone that was left open, so the frame is complete.
+            for (int sample : unfinished) {frame.samples[sample].duration = end - frame.samples[sample].start;}
+            unfinished.clear();
+
+            next = (next + 1) % FRAMES;
+            kept = std::min(kept + 1, FRAMES);
+            recording = false;
+
+        }
+
+        void begin(const char* name) {
+            if (!recordable()) {return;}
+            ProfileFrame& frame = frames[next];
+            unfinished.push_back(frame.samples.size());
+            frame.samples.push_back({name, (int) unfinished.size() - 1, now(), 0.0});
+        }
+
+        void end() {
+            if (!recordable() || unfinished.empty()) {return;}
+            ProfileSample& sample = frames[next].samples[unfinished.back()];
+            sample.duration = now() - sample.start;
+            unfinished.pop_back();
+        }
+
+        void count(const char* name, double value) {
+            if (!recordable()) {return;}
+            std::vector<ProfileCounter>& counters = frames[next].counters;
+            for (ProfileCounter& counter : counters) {
+                if (strcmp(counter.name, name) == 0) {counter.value += value; return;}
+            }
+            counters.push_back({name, value});
+        }
+
+        bool isEnabled() {
+            return enabled;
+        }
+
+        void setEnabled(bool state) {
+            enabled = state;
+            if (!enabled) {recording = false;}
+        }
+
+        int getFrameCount() {
+            return kept;
+        }
+
+        const ProfileFrame& getFrame(int age) {
+            return frames[((next - 1 - age) % FRAMES + FRAMES) % FRAMES];
+        }
+
+        bool save(std::string filename) {
+
+            std::ofstream file(filename);
+            if (!file.is_open()) {
+                std::cout << "ERROR::PROFILER::SAVE::FAILED_TO_OPEN::" << filename << "\n";
+                return false;
+            }
+
+            // Every zone is a complete event, oldest frame first.
+            nlohmann::json events = nlohmann::json::array();
+            for (int age = kept - 1; age >= 0; age--) {
+
+                const ProfileFrame& frame = getFrame(age);
+                events.push_back(event("Frame", frame.start, frame.duration));
+                for (const ProfileSample& sample : frame.samples) {events.push_back(event(sample.name, sample.start, sample.duration));}
+                for (const ProfileCounter& c : frame.counters) {events.push_back(counter(c.name, frame.start, c.value));}
+
+            }
+
+            nlohmann::json j;
+            j.emplace("traceEvents", events);
+            j.emplace("displayTimeUnit", "ms");
+            file << j.dump();
+            return true;
+
+        }
+
+        void open() {
+            active = true;
+        }
+
+        void close() {
+            active = false;
+        }
+
+        void toggle() {
+            active = !active;
+        }
+
+        void render() {
+
+            if (!active || kept == 0) {return;}
+            ImGui::Begin("Profiler");
+
+            // The frame times of every kept frame, oldest first.
+            float times[FRAMES];
+            float worst = 0.0f;
+            for (int age = kept - 1; age >= 0; age--) {
+                times[kept - 1 - age] = getFrame(age).duration / 1000.0;
+                worst = std::max(worst, times[kept - 1 - age]);
+            }
+
+            const ProfileFrame& last = getFrame(0);
+            ImGui::Text("Frame: %.3f ms  Worst: %.3f ms", last.duration / 1000.0, worst);
+            ImGui::PlotLines("##frames", times, kept, 0, nullptr, 0.0f, worst, ImVec2(0.0f, 60.0f));
+
+            // The zones of the last frame, indented by how deeply they are nested.
+            for (const ProfileSample& sample : last.samples) {
+                ImGui::Text("%*s%s: %.3f ms", sample.depth * 2, "", sample.name, sample.duration / 1000.0);
+            }
+
+            for (const ProfileCounter& counter : last.counters) {
+                ImGui::Text("%s: %.0f", counter.name, counter.value);
+            }
+
+            ImGui::End();
+
+        }
+
+        bool opened() {
+            return active;
+        }
+
+    }
+
+}
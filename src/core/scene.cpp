@@ -7,6 +7,7 @@
 
 #include "pancake/core/scene.hpp"
 #include "pancake/core/listener.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/asset/assetpool.hpp"
 #include "pancake/asset/spritesheet.hpp"
 
@@ -22,7 +23,7 @@ namespace Pancake {
         this->camera = new Camera(glm::vec2(0.0f, 0.0f), glm::vec2(12.0f, 12.0f), 1.0f);
         this->renderer = new Renderer();
         this->physics = new World(1.0f / 60.0f, glm::vec2(0.0f, -10.0f));
-        this->grid = new SpatialHashGrid<Entity*>(4);
+        this->tree = new DynamicTree<Entity*>(0.5f);
     }
 
     Scene::~Scene() {
@@ -36,7 +37,7 @@ namespace Pancake {
         delete this->camera;
         delete this->renderer;
         delete this->physics;
-        delete this->grid;
+        delete this->tree;
 
         // Delete all entities and their components.
         for (Entity* e : this->entities) {
@@ -55,22 +56,33 @@ namespace Pancake {
 
     void Scene::update(float dt) {
 
+        PROFILE_ZONE("Scene::update");
+
         // Adjust the projection and step the physics engine.
         this->camera->adjustProjection();
         this->camera->update(dt);
         this->physics->update(dt); // This will update colliding components
 
         // Update all the entities.
+        PROFILE_ZONE("Entities");
         std::deque<int> dead;
         for (int i = 0; i < this->entities.size(); i++) {
             if (!this->entities[i]->isDead()) {this->entities[i]->update(dt);} 
             else {dead.push_front(i);}
         }
 
+        // Refit the bounds of all living entities, most will remain inside their fattened bounds.
+        for (Entity* e : this->entities) {
+            if (e->isDead()) {continue;}
+            std::pair<glm::vec2, glm::vec2> bounds = e->getBounds();
+            this->tree->update(e, bounds.first, bounds.second);
+        }
+
         // Delete all dead elements
         for (int i : dead) {
             Entity* e = this->entities[i];
             this->entityIndex.erase(e->getId());
+            this->tree->remove(e);
             this->entities.erase(this->entities.begin() + i);
             delete e;
         }
@@ -87,6 +99,8 @@ namespace Pancake {
         nlohmann::json j;
         j.emplace("name", this->name);
         j.emplace("camera", this->camera->serialise());
+        j.emplace("broadphase", this->physics->getBroadphase()->serialise());
+        j.emplace("threads", this->physics->getThreadCount());
         j.emplace("fonts", FontPool::serialise());
         j.emplace("spritesheets", Spritesheet::serialise());
         j.emplace("sprites", SpritePool::serialise());
@@ -135,6 +149,23 @@ namespace Pancake {
             this->camera->load(j["camera"]);
         }
 
+        // Load the broadphase used by the physics engine.
+        if (j.contains("broadphase") && j["broadphase"].is_object()) {
+            nlohmann::json element = j["broadphase"];
+            if (element.contains("type") && element["type"].is_string()) {
+                Broadphase* b = FACTORY(Broadphase).create(element["type"]);
+                if (b != nullptr) {
+                    if (!b->load(element)) {delete b;}
+                    else {this->physics->setBroadphase(b);}
+                }
+            }
+        }
+
+        // Load the number of threads used by the physics engine.
+        if (j.contains("threads") && j["threads"].is_number_integer()) {
+            this->physics->setThreadCount(j["threads"]);
+        }
+
         // Load fonts into the font pool
         if (j.contains("fonts") && j["fonts"].is_array()) {
             for (auto element : j["fonts"]) {
@@ -211,6 +242,8 @@ namespace Pancake {
         this->entities.push_back(entity);
         std::pair<int, Entity*> p(entity->getId(), entity);
         this->entityIndex.insert(p);
+        std::pair<glm::vec2, glm::vec2> bounds = entity->getBounds();
+        this->tree->add(entity, bounds.first, bounds.second);
         if (this->started) {entity->start();}
     }
 
@@ -232,4 +265,10 @@ namespace Pancake {
         return &this->componentIndex;
     }
 
+    std::vector<Entity*> Scene::query(glm::vec2 min, glm::vec2 max) {
+        std::vector<Entity*> result;
+        this->tree->query(min, max, result);
+        return result;
+    }
+
 }
\ No newline at end of file
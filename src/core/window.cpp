@@ -14,6 +14,7 @@
 
 #include "pancake/core/window.hpp"
 #include "pancake/core/listener.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/graphics/shader.hpp"
 #include "pancake/graphics/framebuffer.hpp"
 #include "pancake/graphics/debugdraw.hpp"
@@ -57,6 +58,8 @@ namespace Pancake {
 
         Shader* defaultShader;
         Shader* entityShader;
+        Shader* defaultArrayShader;
+        Shader* entityArrayShader;
         Framebuffer* entityTexture;
 
         void update(float dt) {
@@ -66,33 +69,42 @@ namespace Pancake {
         void render() {
 
             // Render the scene to the entity picking texture.
+            Profiler::begin("Picking");
             glDisable(GL_BLEND);
             entityTexture->bind();
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
-            Renderer::bindShader(entityShader);
+            Renderer::bindShader(entityShader, entityArrayShader);
             scene->render();
             entityTexture->unbind();
             glEnable(GL_BLEND);
+            Profiler::end();
 
             // Render the scene to the window.
+            Profiler::begin("Render");
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
-            Renderer::bindShader(defaultShader);
+            Renderer::bindShader(defaultShader, defaultArrayShader);
             scene->render();
+            Profiler::end();
 
             // Debug draw
             DebugDraw::render();
 
             // Imgui Render
+            Profiler::begin("ImGui");
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
             Console::render();
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            Profiler::end();
 
+            // Includes waiting for the vertical sync.
+            Profiler::begin("Swap");
             glfwSwapBuffers(window);
+            Profiler::end();
 
         }
 
@@ -187,6 +199,8 @@ namespace Pancake {
             AssetPool::init();
             defaultShader = new Shader("default", "default", DEFAULT_VERTEX, DEFAULT_FRAGMENT);
             entityShader = new Shader("default", "entity", DEFAULT_VERTEX, ENTITY_FRAGMENT);
+            defaultArrayShader = new Shader("default", "array", DEFAULT_VERTEX, ARRAY_FRAGMENT);
+            entityArrayShader = new Shader("default", "entityarray", DEFAULT_VERTEX, ENTITY_ARRAY_FRAGMENT);
             entityTexture = new Framebuffer(GL_RGB32F, width, height, GL_RGB, GL_FLOAT);
             DebugDraw::init();
             scene = new Scene();
@@ -265,8 +279,10 @@ namespace Pancake {
                 }
 
                 if (dt > 0) {
+                    Profiler::beginFrame();
                     update(dt);
                     render();
+                    Profiler::endFrame();
                 }
 
                 MouseListener::endFrame();
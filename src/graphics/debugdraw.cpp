@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include "pancake/graphics/shader.hpp"
 #include "pancake/graphics/debugdraw.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/core/window.hpp"
 #include "pancake/asset/shaders.hpp"
 
@@ -90,6 +91,8 @@ namespace Pancake {
 
         void render() {
 
+            PROFILE_ZONE("DebugDraw::render");
+
             for (int i = 0; i < lines.size(); i++) {
                 Line* current = lines[i];
                 current->lifetime--;
@@ -1,8 +1,12 @@
 #include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
 #include <glm/gtx/transform.hpp>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 #include "pancake/graphics/renderer.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/core/window.hpp"
 
 using glm::vec2;
@@ -32,7 +36,27 @@ namespace Pancake {
         const int MAX_TEXTURES_SIZE = 7;
         const int MAX_BATCH_SIZE = 1000;
 
+        // Dirty ranges this many quads apart or closer are uploaded together, saving a call for a few clean quads.
+        const int UPLOAD_GAP = 8;
+
+        // Streamed batches keep a region for the frame being written and two the GPU may still be reading.
+        const int STREAM_REGIONS = 3;
+        const int STREAM_REGION_BYTES = MAX_BATCH_SIZE * 4 * VERTEX_SIZE_BYTES;
+        const GLuint64 STREAM_TIMEOUT = 1000000; // Nanoseconds.
+
+        // Texture ids of quads in array batches hold the layer as well, above the slots.
+        const int ARRAY_LAYER_STRIDE = MAX_TEXTURES_SIZE + 1;
+
+        // The texture a quad samples, which for images packed into an atlas is the atlas.
+        Texture* source(Texture* texture) {
+            if (texture != nullptr && texture->getAtlas() != nullptr) {return texture->getAtlas();}
+            return texture;
+        }
+
         Shader* boundShader = nullptr;
+        Shader* boundArrayShader = nullptr;
+        bool streaming = false;
+        bool textureArrays = false;
 
     }
 
@@ -47,6 +71,7 @@ namespace Pancake {
     }
 
     void Renderer::render() {
+        PROFILE_ZONE("Renderer::render");
         for (RenderBatch* current : this->batches) {
             current->render();
         }
@@ -92,24 +117,49 @@ namespace Pancake {
     }
 
     void Renderer::remove(SpriteRenderer* sprite) {
-        for (RenderBatch* current : this->batches) {
-            current->removeSprite(sprite);
-        }
+        if (sprite->getBatch() != nullptr) {sprite->getBatch()->removeSprite(sprite);}
     }
 
     void Renderer::bindShader(Shader* shader) {
         boundShader = shader;
     }
 
+    void Renderer::bindShader(Shader* shader, Shader* arrayShader) {
+        boundShader = shader;
+        boundArrayShader = arrayShader;
+    }
+
     Shader* Renderer::getBoundShader(Shader* shader) {
         return boundShader;
     }
 
+    bool Renderer::isStreaming() {
+        return streaming;
+    }
+
+    void Renderer::setStreaming(bool state) {
+        streaming = state;
+    }
+
+    bool Renderer::isUsingTextureArrays() {
+        return textureArrays;
+    }
+
+    void Renderer::setUsingTextureArrays(bool state) {
+        textureArrays = state;
+    }
+
     RenderBatch::RenderBatch(Renderer* renderer, int zIndex) {
 
         this->renderer = renderer;
         this->vertices = (float*) malloc(MAX_BATCH_SIZE * 4 * VERTEX_SIZE_BYTES);
         this->zIndex = zIndex;
+        this->arrayed = textureArrays;
+
+        // Fences and base vertices are core from OpenGL 3.2.
+        this->streaming = streaming && GLAD_GL_VERSION_3_2;
+        this->region = 0;
+        this->fences.assign(STREAM_REGIONS, nullptr);
 
         // Generate and bind a Vertex Array Object
         glGenVertexArrays(1, &this->vao);
@@ -118,7 +168,8 @@ namespace Pancake {
         // Allocate space for vertices
         glGenBuffers(1, &this->vbo);
         glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-        glBufferData(GL_ARRAY_BUFFER, MAX_BATCH_SIZE * 4 * VERTEX_SIZE_BYTES, nullptr, GL_DYNAMIC_DRAW);
+        if (this->streaming) {glBufferData(GL_ARRAY_BUFFER, STREAM_REGIONS * STREAM_REGION_BYTES, nullptr, GL_STREAM_DRAW);}
+        else {glBufferData(GL_ARRAY_BUFFER, STREAM_REGION_BYTES, nullptr, GL_DYNAMIC_DRAW);}
 
         // Create and upload the indices buffer.
         unsigned int ebo;
@@ -153,6 +204,9 @@ namespace Pancake {
 
     RenderBatch::~RenderBatch() {
         free(this->vertices);
+        for (GLsync fence : this->fences) {
+            if (fence != nullptr) {glDeleteSync(fence);}
+        }
     }
 
     void RenderBatch::generateIndices(int* elements) {
@@ -191,9 +245,19 @@ namespace Pancake {
         vec2* texCoords = sprite->getSprite()->getTexCoords();
 
         int texId = 0;
-        if (sprite->getSprite()->getTexture() != nullptr) {
+        Texture* image = sprite->getSprite()->getTexture();
+        Texture* texture = source(image);
+        if (texture != nullptr && this->arrayed) {
+            for (int i = 0; i < this->arrays.size(); i++) {
+                if (this->arrays[i] == texture->getArray()) {
+                    texId = i + 1 + texture->getLayer() * ARRAY_LAYER_STRIDE;
+                    break;
+                }
+            }
+        }
+        else if (texture != nullptr) {
             for (int i = 0; i < this->textures.size(); i++) {
-                if (this->textures[i] == sprite->getSprite()->getTexture()) {
+                if (this->textures[i] == texture) {
                     texId = i + 1;
                     break;
                 }
@@ -251,8 +315,9 @@ namespace Pancake {
             this->vertices[offset + 5] = colour.w;
 
             // Load Texture Coordinates
-            this->vertices[offset + 6] = texCoords[i].x;
-            this->vertices[offset + 7] = texCoords[i].y;
+            vec2 uv = image != nullptr ? image->getAtlasCoords(texCoords[i]) : texCoords[i];
+            this->vertices[offset + 6] = uv.x;
+            this->vertices[offset + 7] = uv.y;
 
             // Load Texture ID
             this->vertices[offset + 8] = texId;
@@ -268,7 +333,6 @@ namespace Pancake {
 
     void RenderBatch::render() {
 
-        bool rebuffer = false;
         for (int i = 0; i < this->sprites.size(); i++) {
 
             SpriteRenderer* current = this->sprites[i];
@@ -284,44 +348,59 @@ namespace Pancake {
                 else {
                     this->loadVertexProperties(i);
                     current->setClean();
-                    rebuffer = true;
+                    this->setDirty(i, i);
                 }
 
             }
 
         }
 
-        if (rebuffer) {
-            glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, MAX_BATCH_SIZE * 4 * VERTEX_SIZE_BYTES, this->vertices);
-        }
+        this->upload();
 
         // Use shader
-        boundShader->bind();
+        Shader* shader = this->arrayed ? boundArrayShader : boundShader;
+        if (shader == nullptr) {return;}
+        shader->bind();
 
         Camera* camera = Window::getScene()->getCamera();
 
         mat4 view = camera->getView();
         mat4 projection = camera->getProjection();
-        boundShader->uploadMat4("uProjection", projection);
-        boundShader->uploadMat4("uView", view);
+        shader->uploadMat4("uProjection", projection);
+        shader->uploadMat4("uView", view);
 
         for (int i = 0; i < this->textures.size(); i++) {
             glActiveTexture(GL_TEXTURE0 + i + 1);
             this->textures[i]->bind();
         }
+        for (int i = 0; i < this->arrays.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + i + 1);
+            this->arrays[i]->bind();
+        }
         int slots[] = {0, 1, 2, 3, 4, 5, 6, 7};
-        boundShader->uploadIntArray("uTextures", MAX_TEXTURES_SIZE+1, slots);
+        shader->uploadIntArray("uTextures", MAX_TEXTURES_SIZE+1, slots);
 
         glBindVertexArray(this->vao);
-        glDrawElements(GL_TRIANGLES, this->sprites.size() * 6, GL_UNSIGNED_INT, 0);
+        if (this->streaming) {
+
+            // Draw from the region last written, and fence it so it is not written again while being read.
+            glDrawElementsBaseVertex(GL_TRIANGLES, this->sprites.size() * 6, GL_UNSIGNED_INT, 0, this->region * MAX_BATCH_SIZE * 4);
+            if (this->fences[this->region] != nullptr) {glDeleteSync(this->fences[this->region]);}
+            this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        }
+        else {glDrawElements(GL_TRIANGLES, this->sprites.size() * 6, GL_UNSIGNED_INT, 0);}
         glBindVertexArray(0);
 
         for (int i = 0; i < this->textures.size(); i++) {
             glActiveTexture(GL_TEXTURE0 + i + 1);
             this->textures[i]->unbind();
         }
-        boundShader->unbind();
+        for (int i = 0; i < this->arrays.size(); i++) {
+            glActiveTexture(GL_TEXTURE0 + i + 1);
+            this->arrays[i]->unbind();
+        }
+        shader->unbind();
 
     }
 
@@ -333,6 +412,7 @@ namespace Pancake {
         // Get the index and add it to the list.
         int index = this->sprites.size();
         this->sprites.push_back(sprite);
+        sprite->setBatch(this, index);
 
         // Add the sprite's texture, if the batch does not have it.
         if (sprite->getSprite()->getTexture() != nullptr) {
@@ -341,63 +421,197 @@ namespace Pancake {
 
         // Add properties to local vertices array.
         this->loadVertexProperties(index);
+        this->setDirty(index, index);
 
     }
 
     void RenderBatch::removeSprite(SpriteRenderer* sprite) {
 
-        // Remove the sprite from the batch if in the batch.
-        bool removed = false;
-        int n = this->sprites.size();
-        for (int i = 0; i < n; i++) {
-            SpriteRenderer* current = this->sprites[i];
-            if (current == sprite) {
-                this->sprites.erase(this->sprites.begin() + i);
-                removed = true;
-                break;
+        if (sprite->getBatch() != this) {return;}
+
+        // Move the last sprite into the removed one's slot, so only its quad changes.
+        int slot = sprite->getSlot();
+        int last = this->sprites.size() - 1;
+        if (slot != last) {
+            this->sprites[slot] = this->sprites[last];
+            this->sprites[slot]->setBatch(this, slot);
+            this->loadVertexProperties(slot);
+            this->setDirty(slot, slot);
+        }
+        this->sprites.pop_back();
+        sprite->setBatch(nullptr, -1);
+
+        // Remove the texture if not used anymore.
+        this->removeTextureIfNotUsed(sprite->getSprite()->getTexture());
+
+    }
+
+    void RenderBatch::setDirty(int first, int last) {
+
+        if (first > last) {return;}
+
+        // Extend the last range if this one touches it, which is the usual case as render walks the sprites in order.
+        if (!this->dirty.empty()) {
+            std::pair<int, int>& previous = this->dirty.back();
+            if (first >= previous.first && first <= previous.second + UPLOAD_GAP) {
+                previous.second = std::max(previous.second, last);
+                return;
             }
         }
 
-        if (removed) {
+        this->dirty.push_back(std::make_pair(first, last));
 
-            // Rebuffer the data if we removed it.
-            for (int i = 0; i < this->sprites.size(); i++) {
-                SpriteRenderer* current = this->sprites[i];
-                this->loadVertexProperties(i);
+    }
+
+    void RenderBatch::upload() {
+
+        if (this->dirty.empty()) {return;}
+        if (this->streaming) {
+            this->stream();
+            return;
+        }
+
+        // Merge the ranges that overlap or are close, then upload each.
+        std::sort(this->dirty.begin(), this->dirty.end());
+        int n = this->sprites.size();
+        int uploaded = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+
+        int i = 0;
+        while (i < this->dirty.size()) {
+
+            int first = this->dirty[i].first;
+            int last = this->dirty[i].second;
+            for (i++; i < this->dirty.size() && this->dirty[i].first <= last + UPLOAD_GAP; i++) {
+                last = std::max(last, this->dirty[i].second);
             }
 
-            glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, MAX_BATCH_SIZE * 4 * VERTEX_SIZE_BYTES, this->vertices);
+            // Quads past the end of the batch are not drawn, so are not worth uploading.
+            last = std::min(last, n - 1);
+            if (first > last) {continue;}
+
+            int offset = first * 4 * VERTEX_SIZE;
+            int bytes = (last - first + 1) * 4 * VERTEX_SIZE_BYTES;
+            glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(float), bytes, this->vertices + offset);
+            uploaded += bytes;
 
-            // Remove the texture if not used anymore.
-            this->removeTextureIfNotUsed(sprite->getSprite()->getTexture());
-            
         }
 
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        this->dirty.clear();
+        Profiler::count("Uploaded bytes", uploaded);
+
+    }
+
+    void RenderBatch::stream() {
+
+        // The next region holds vertices from two changes ago, so every quad is written, not only the dirty ones.
+        int n = this->sprites.size();
+        int next = (this->region + 1) % STREAM_REGIONS;
+        int bytes = n * 4 * VERTEX_SIZE_BYTES;
+        if (n == 0) {
+            this->dirty.clear();
+            return;
+        }
+
+        // Only waits if the GPU is more than two frames behind.
+        if (this->fences[next] != nullptr) {
+            while (glClientWaitSync(this->fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_TIMEOUT) == GL_TIMEOUT_EXPIRED) {}
+            glDeleteSync(this->fences[next]);
+            this->fences[next] = nullptr;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, next * STREAM_REGION_BYTES, bytes, access);
+
+        // Fall back to plain uploads into the first region if the driver will not map it.
+        if (mapped == nullptr) {
+            std::cout << "ERROR::RENDERBATCH::STREAM::FAILED_TO_MAP_BUFFER\n";
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            this->streaming = false;
+            this->region = 0;
+            this->setDirty(0, n - 1);
+            this->upload();
+            return;
+        }
+
+        memcpy(mapped, this->vertices, bytes);
+
+        // The contents are lost if the buffer was corrupted while mapped, so try again next frame.
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        this->region = next;
+        this->dirty.clear();
+        Profiler::count("Uploaded bytes", bytes);
+
     }
 
     void RenderBatch::addTexture(Texture* texture) {
+        texture = source(texture);
         if (this->hasTexture(texture)) {return;}
-        if (this->hasTextureRoom()) {this->textures.push_back(texture);}
+
+        // Textures are put in an array when first added to a batch, which may be one the batch already has.
+        if (this->arrayed) {
+            TextureArray* array = TextureArray::place(texture);
+            if (array == nullptr) {return;}
+            for (TextureArray* current : this->arrays) {
+                if (current == array) {return;}
+            }
+            if (this->hasTextureRoom()) {this->arrays.push_back(array);}
+            return;
+        }
+
+        if (!this->hasTextureRoom()) {return;}
+        this->textures.push_back(texture);
     }
 
     void RenderBatch::removeTextureIfNotUsed(Texture* texture) {
 
         // If the texture is nullptr, we don't need to remove it.
+        texture = source(texture);
         if (texture == nullptr) {return;}
 
+        // Array batches remove the texture's array once no sprite uses any texture in it.
+        if (this->arrayed) {
+
+            TextureArray* array = texture->getArray();
+            if (array == nullptr) {return;}
+            for (SpriteRenderer* current : this->sprites) {
+                Texture* t = source(current->getSprite()->getTexture());
+                if (t != nullptr && t->getArray() == array) {return;}
+            }
+
+            for (int i = 0; i < this->arrays.size(); i++) {
+                if (this->arrays[i] == array) {
+                    this->arrays.erase(this->arrays.begin() + i);
+                    for (int j = 0; j < this->sprites.size(); j++) {this->loadVertexProperties(j);}
+                    this->setDirty(0, this->sprites.size() - 1);
+                    return;
+                }
+            }
+            return;
+
+        }
+
         // Check if any sprite in the batch uses the texture,
         // If no sprite does, we can remove it.
         for (SpriteRenderer* current : this->sprites) {
-            if (current->getSprite()->getTexture() == texture) {return;}
+            if (source(current->getSprite()->getTexture()) == texture) {return;}
         }
 
-        // Remove the texture.
+        // Remove the texture. The textures after it move down a slot, so every sprite's texture id is reloaded.
         int n = this->textures.size();
         for (int i = 0; i < n; i++) {
             Texture* current = this->textures[i];
             if (current == texture) {
                 this->textures.erase(this->textures.begin() + i);
+                for (int j = 0; j < this->sprites.size(); j++) {this->loadVertexProperties(j);}
+                this->setDirty(0, this->sprites.size() - 1);
                 return;
             }
         }
@@ -409,10 +623,27 @@ namespace Pancake {
     }
 
     bool RenderBatch::hasTextureRoom() {
+        if (this->arrayed) {return this->arrays.size() < MAX_TEXTURES_SIZE;}
         return this->textures.size() < MAX_TEXTURES_SIZE;
     }
 
     bool RenderBatch::hasTexture(Texture* texture) {
+
+        texture = source(texture);
+
+        // Textures are only put in an array by addTexture, so one that is not in an array yet is not in any
+        // batch. One that can not be is drawn untextured in any batch, rather than being moved between batches
+        // looking for its array.
+        if (this->arrayed) {
+            if (texture == nullptr) {return false;}
+            TextureArray* array = texture->getArray();
+            if (array == nullptr) {return TextureArray::isRejected(texture);}
+            for (TextureArray* current : this->arrays) {
+                if (current == array) {return true;}
+            }
+            return false;
+        }
+
         for (Texture* current : this->textures) {
             if (current == texture) {return true;}
         }
@@ -94,11 +94,13 @@ namespace Pancake {
             
             if (this->texture != nullptr) {
                 
+                vec2 min = this->texture->getAtlasCoords(this->texCoords[3]);
+                vec2 max = this->texture->getAtlasCoords(this->texCoords[1]);
                 ImGui::Image(
                     (void*)(intptr_t)this->texture->getId(), 
                     ImVec2(100, 100),
-                    ImVec2(this->texCoords[3].x, this->texCoords[3].y),
-                    ImVec2(this->texCoords[1].x, this->texCoords[1].y)
+                    ImVec2(min.x, min.y),
+                    ImVec2(max.x, max.y)
                 );
             
             }
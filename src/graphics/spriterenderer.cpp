@@ -18,6 +18,9 @@ namespace Pancake {
 
         this->dirty = true;
 
+        this->batch = nullptr;
+        this->slot = -1;
+
     }
 
     void SpriteRenderer::start() {
@@ -142,6 +145,14 @@ namespace Pancake {
         return this->dirty;
     }
 
+    RenderBatch* SpriteRenderer::getBatch() {
+        return this->batch;
+    }
+
+    int SpriteRenderer::getSlot() {
+        return this->slot;
+    }
+
     SpriteRenderer* SpriteRenderer::setSprite(string sprite) {
         return this->setSprite(SpritePool::get(sprite));
     }
@@ -184,4 +195,10 @@ namespace Pancake {
         return this;
     }
 
+    SpriteRenderer* SpriteRenderer::setBatch(RenderBatch* batch, int slot) {
+        this->batch = batch;
+        this->slot = slot;
+        return this;
+    }
+
 }
\ No newline at end of file
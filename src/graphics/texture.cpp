@@ -2,6 +2,7 @@
 #include <glad/glad.h>
 #include <stb/stb_image.h>
 #include "pancake/graphics/texture.hpp"
+#include "pancake/graphics/texturearray.hpp"
 
 namespace Pancake {
 
@@ -11,6 +12,11 @@ namespace Pancake {
         this->name = name;
         this->width = width;
         this->height = height;
+        this->array = nullptr;
+        this->layer = -1;
+        this->atlas = nullptr;
+        this->regionMin = vec2(0.0f, 0.0f);
+        this->regionMax = vec2(1.0f, 1.0f);
 
         if (image != nullptr && (channels == 3 || channels == 4)) {
 
@@ -51,6 +57,8 @@ namespace Pancake {
             unsigned char missing[] = {0,0,0,255,0,255,0,0,255,0,255,0,0};
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, missing);
             this->missingFlag = true;
+            this->width = 2;
+            this->height = 2;
 
         }
 
@@ -61,6 +69,13 @@ namespace Pancake {
         // Store the string.
         this->name = "generated";
         this->missingFlag = false;
+        this->width = width;
+        this->height = height;
+        this->array = nullptr;
+        this->layer = -1;
+        this->atlas = nullptr;
+        this->regionMin = vec2(0.0f, 0.0f);
+        this->regionMax = vec2(1.0f, 1.0f);
 
         // Generate texture on GPU
         glGenTextures(1, &this->id);
@@ -80,6 +95,13 @@ namespace Pancake {
         // Label the texture as missing
         this->name = "missing";
         this->missingFlag = true;
+        this->width = 2;
+        this->height = 2;
+        this->array = nullptr;
+        this->layer = -1;
+        this->atlas = nullptr;
+        this->regionMin = vec2(0.0f, 0.0f);
+        this->regionMax = vec2(1.0f, 1.0f);
 
         // Generate texture on GPU
         glGenTextures(1, &this->id);
@@ -127,8 +149,25 @@ namespace Pancake {
         this->generate(internal, width, height, format, type);
     }
 
+    Texture::Texture(string name, Texture* atlas, vec2 regionMin, vec2 regionMax, int width, int height) {
+
+        // A region of an atlas shares the atlas' texture on the GPU.
+        this->name = name;
+        this->id = atlas->getId();
+        this->width = width;
+        this->height = height;
+        this->missingFlag = false;
+        this->array = nullptr;
+        this->layer = -1;
+        this->atlas = atlas;
+        this->regionMin = regionMin;
+        this->regionMax = regionMax;
+
+    }
+
     Texture::~Texture() {
-        glDeleteTextures(1, &this->id);
+        if (this->array != nullptr) {this->array->remove(this->layer);}
+        if (this->atlas == nullptr) {glDeleteTextures(1, &this->id);}
     }
 
     void Texture::bind() {
@@ -139,6 +178,17 @@ namespace Pancake {
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    void Texture::update(int x, int y, int width, int height, unsigned char* pixels) {
+
+        glBindTexture(GL_TEXTURE_2D, this->id);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // Keep the copy in an array texture up to date.
+        if (this->array != nullptr) {this->array->update(this->layer, x, y, width, height);}
+
+    }
+
     string Texture::getName() {
         return this->name;
     }
@@ -159,4 +209,25 @@ namespace Pancake {
         return this->missingFlag;
     }
 
+    TextureArray* Texture::getArray() {
+        return this->array;
+    }
+
+    int Texture::getLayer() {
+        return this->layer;
+    }
+
+    Texture* Texture::getAtlas() {
+        return this->atlas;
+    }
+
+    vec2 Texture::getAtlasCoords(vec2 texCoords) {
+        return this->regionMin + texCoords * (this->regionMax - this->regionMin);
+    }
+
+    void Texture::setArray(TextureArray* array, int layer) {
+        this->array = array;
+        this->layer = layer;
+    }
+
 }
\ No newline at end of file
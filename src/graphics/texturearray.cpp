@@ -0,0 +1,166 @@
+#include <iostream>
+#include <algorithm>
+#include <glad/glad.h>
+#include "pancake/graphics/texturearray.hpp"
+
+namespace Pancake {
+
+    namespace {
+
+        // Small textures share an array of up to the guaranteed minimum layer count, large ones get fewer
+        // layers, so an array never reserves much more video memory than this.
+        const int MAX_LAYERS = 256;
+        const int MAX_ARRAY_BYTES = 16 * 1024 * 1024;
+
+        // The arrays outlive the scenes, as the textures in the pool do.
+        std::vector<TextureArray*> arrays;
+
+        // The layer given to a texture that could not be placed in any array.
+        const int REJECTED_LAYER = -2;
+
+        TextureArray* reject(Texture* texture) {
+            texture->setArray(nullptr, REJECTED_LAYER);
+            return nullptr;
+        }
+
+    }
+
+    TextureArray::TextureArray(int width, int height, int layers) {
+
+        this->width = width;
+        this->height = height;
+        this->textures.assign(layers, nullptr);
+
+        // Generate the array texture on the GPU, with the same parameters as single textures.
+        glGenTextures(1, &this->id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    }
+
+    TextureArray::~TextureArray() {
+        for (Texture* texture : this->textures) {
+            if (texture != nullptr) {texture->setArray(nullptr, -1);}
+        }
+        glDeleteTextures(1, &this->id);
+    }
+
+    int TextureArray::add(Texture* texture) {
+
+        if (texture->getWidth() != this->width || texture->getHeight() != this->height) {return -1;}
+
+        int layer = -1;
+        for (int i = 0; i < this->textures.size(); i++) {
+            if (this->textures[i] == nullptr) {
+                layer = i;
+                break;
+            }
+        }
+        if (layer == -1) {return -1;}
+        if (!this->copy(texture, layer, 0, 0, this->width, this->height)) {return -1;}
+
+        this->textures[layer] = texture;
+        texture->setArray(this, layer);
+        return layer;
+
+    }
+
+    void TextureArray::remove(int layer) {
+        if (layer < 0 || layer >= this->textures.size()) {return;}
+        this->textures[layer] = nullptr;
+    }
+
+    void TextureArray::update(int layer, int x, int y, int width, int height) {
+        if (layer < 0 || layer >= this->textures.size() || this->textures[layer] == nullptr) {return;}
+        this->copy(this->textures[layer], layer, x, y, width, height);
+    }
+
+    bool TextureArray::copy(Texture* texture, int layer, int x, int y, int width, int height) {
+
+        // The image is not kept once uploaded, so it is copied on the GPU by reading the texture through a framebuffer.
+        GLint previous;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+        unsigned int fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getId(), 0);
+
+        bool copied = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (copied) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+            glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, x, y, width, height);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        }
+        else {std::cout << "ERROR::TEXTUREARRAY::COPY_FAILED '" << texture->getName() << "'\n";}
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+        glDeleteFramebuffers(1, &fbo);
+        return copied;
+
+    }
+
+    void TextureArray::bind() {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->id);
+    }
+
+    void TextureArray::unbind() {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    unsigned int TextureArray::getId() {
+        return this->id;
+    }
+
+    int TextureArray::getWidth() {
+        return this->width;
+    }
+
+    int TextureArray::getHeight() {
+        return this->height;
+    }
+
+    int TextureArray::getLayers() {
+        return this->textures.size();
+    }
+
+    bool TextureArray::isFull() {
+        for (Texture* texture : this->textures) {
+            if (texture == nullptr) {return false;}
+        }
+        return true;
+    }
+
+    TextureArray* TextureArray::place(Texture* texture) {
+
+        if (texture->getArray() != nullptr) {return texture->getArray();}
+        if (isRejected(texture)) {return nullptr;}
+
+        int width = texture->getWidth();
+        int height = texture->getHeight();
+        if (width <= 0 || height <= 0) {return reject(texture);}
+
+        // Use an array of the same size with room.
+        for (TextureArray* current : arrays) {
+            if (current->getWidth() == width && current->getHeight() == height && !current->isFull()) {
+                return current->add(texture) != -1 ? current : reject(texture);
+            }
+        }
+
+        // Otherwise start a new one, fitting as many layers as the budget allows.
+        int layers = std::max(1, std::min(MAX_LAYERS, MAX_ARRAY_BYTES / (width * height * 4)));
+        TextureArray* array = new TextureArray(width, height, layers);
+        arrays.push_back(array);
+        return array->add(texture) != -1 ? array : reject(texture);
+
+    }
+
+    bool TextureArray::isRejected(Texture* texture) {
+        return texture->getArray() == nullptr && texture->getLayer() == REJECTED_LAYER;
+    }
+
+}
@@ -0,0 +1,264 @@
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/geometric.hpp>
+
+#include "pancake/core/entity.hpp"
+#include "pancake/physics/bodies.hpp"
+#include "pancake/physics/arbiter.hpp"
+#include "pancake/physics/rigidbody.hpp"
+
+namespace Pancake {
+
+    namespace {
+
+        // Approach speeds below this are treated as resting contact and do not bounce.
+        const float RESTITUTION_THRESHOLD = 1.0f;
+
+        // The largest angle between the old and new normal, as a cosine, for an impulse to be carried over.
+        const float WARM_START_COSINE = 0.9f;
+
+        // The furthest a contact point can move between steps and still be treated as the same point.
+        const float WARM_START_DISTANCE = 0.1f;
+
+        inline glm::vec2 perp(glm::vec2 v) {
+            return glm::vec2(-v.y, v.x);
+        }
+
+        inline float cross(glm::vec2 a, glm::vec2 b) {
+            return a.x * b.y - a.y * b.x;
+        }
+
+    }
+
+    Contact::Contact() {
+        this->feature = 0;
+        this->normalImpulse = 0.0f;
+        this->tangentImpulse = 0.0f;
+        this->normalMass = 0.0f;
+        this->tangentMass = 0.0f;
+        this->bias = 0.0f;
+        this->rA = glm::vec2(0.0f, 0.0f);
+        this->rB = glm::vec2(0.0f, 0.0f);
+    }
+
+    Contact::Contact(CollisionManifold manifold, int feature) : Contact() {
+        this->manifold = manifold;
+        this->feature = feature;
+    }
+
+    Arbiter::Arbiter() {
+        this->a = nullptr;
+        this->b = nullptr;
+        this->bodies = nullptr;
+        this->friction = 0.0f;
+        this->restitution = 0.0f;
+        this->stamp = -1;
+        this->bodyA = -1;
+        this->bodyB = -1;
+        this->inverseMassA = 0.0f;
+        this->inverseMassB = 0.0f;
+        this->inverseMomentA = 0.0f;
+        this->inverseMomentB = 0.0f;
+    }
+
+    Arbiter::Arbiter(Rigidbody* a, Rigidbody* b, BodyStore* bodies) : Arbiter() {
+        this->a = a;
+        this->b = b;
+        this->bodies = bodies;
+    }
+
+    glm::vec2 Arbiter::relativeVelocity(const Contact& c) {
+        BodyStore* s = this->bodies;
+        int i = this->bodyA;
+        int j = this->bodyB;
+        glm::vec2 a = glm::vec2(s->velocityX[i], s->velocityY[i]) + perp(c.rA) * s->angularVelocity[i];
+        glm::vec2 b = glm::vec2(s->velocityX[j], s->velocityY[j]) + perp(c.rB) * s->angularVelocity[j];
+        return b - a;
+    }
+
+    void Arbiter::apply(const Contact& c, glm::vec2 impulse) {
+
+        // Static rigidbodies are shared between arbiters solved in parallel, so they are never written to.
+        BodyStore* s = this->bodies;
+        if (this->inverseMassA > 0.0f) {
+            int i = this->bodyA;
+            s->velocityX[i] -= impulse.x * this->inverseMassA;
+            s->velocityY[i] -= impulse.y * this->inverseMassA;
+            s->angularVelocity[i] -= this->inverseMomentA * cross(c.rA, impulse);
+        }
+
+        if (this->inverseMassB > 0.0f) {
+            int j = this->bodyB;
+            s->velocityX[j] += impulse.x * this->inverseMassB;
+            s->velocityY[j] += impulse.y * this->inverseMassB;
+            s->angularVelocity[j] += this->inverseMomentB * cross(c.rB, impulse);
+        }
+
+    }
+
+    Rigidbody* Arbiter::getA() {
+        return this->a;
+    }
+
+    Rigidbody* Arbiter::getB() {
+        return this->b;
+    }
+
+    std::vector<Contact>& Arbiter::getContacts() {
+        return this->contacts;
+    }
+
+    int Arbiter::getStamp() {
+        return this->stamp;
+    }
+
+    Arbiter* Arbiter::setStamp(int stamp) {
+        this->stamp = stamp;
+        return this;
+    }
+
+    void Arbiter::update(const Contact* contacts, int count) {
+
+        // Carry over the accumulated impulses of contacts that still exist. The narrowphase does not
+        // label its points, so a contact is matched with the nearest old point from the same colliders.
+        this->previous.swap(this->contacts);
+        this->contacts.assign(contacts, contacts + count);
+
+        int m = this->previous.size();
+        for (Contact& contact : this->contacts) {
+
+            int match = -1;
+            float best = WARM_START_DISTANCE * WARM_START_DISTANCE;
+
+            for (int j = 0; j < m; j++) {
+                const Contact& old = this->previous[j];
+                if (old.feature != contact.feature) {continue;}
+                if (glm::dot(old.manifold.normal, contact.manifold.normal) < WARM_START_COSINE) {continue;}
+                glm::vec2 offset = old.manifold.point - contact.manifold.point;
+                float distance = glm::dot(offset, offset);
+                if (distance < best) {match = j; best = distance;}
+            }
+
+            if (match != -1) {
+                contact.normalImpulse = this->previous[match].normalImpulse;
+                contact.tangentImpulse = this->previous[match].tangentImpulse;
+            }
+
+        }
+
+        this->friction = std::max(this->a->getFriction(), this->b->getFriction());
+        this->restitution = this->a->getRestitution() * this->b->getRestitution();
+
+    }
+
+    void Arbiter::preStep() {
+
+        this->bodyA = this->a->getBody();
+        this->bodyB = this->b->getBody();
+        this->inverseMassA = this->bodies->inverseMass[this->bodyA];
+        this->inverseMassB = this->bodies->inverseMass[this->bodyB];
+        this->inverseMomentA = this->bodies->inverseMoment[this->bodyA];
+        this->inverseMomentB = this->bodies->inverseMoment[this->bodyB];
+
+        float invMassA = this->inverseMassA;
+        float invMassB = this->inverseMassB;
+        float invMoiA = this->inverseMomentA;
+        float invMoiB = this->inverseMomentB;
+        glm::vec2 centroidA = this->a->getCentroid();
+        glm::vec2 centroidB = this->b->getCentroid();
+
+        for (Contact& c : this->contacts) {
+
+            glm::vec2 normal = c.manifold.normal;
+            glm::vec2 tangent = perp(normal);
+            c.rA = c.manifold.point - centroidA;
+            c.rB = c.manifold.point - centroidB;
+
+            // The effective mass along the normal and tangent.
+            float rnA = cross(c.rA, normal);
+            float rnB = cross(c.rB, normal);
+            float rtA = cross(c.rA, tangent);
+            float rtB = cross(c.rB, tangent);
+            c.normalMass = 1.0f / (invMassA + invMassB + invMoiA * rnA * rnA + invMoiB * rnB * rnB);
+            c.tangentMass = 1.0f / (invMassA + invMassB + invMoiA * rtA * rtA + invMoiB * rtB * rtB);
+
+            // Bounce off the approach speed at the start of the step, not the partially solved one.
+            float approach = glm::dot(this->relativeVelocity(c), normal);
+            c.bias = approach < -RESTITUTION_THRESHOLD ? -this->restitution * approach : 0.0f;
+
+        }
+
+    }
+
+    void Arbiter::warmStart() {
+        for (const Contact& c : this->contacts) {
+            glm::vec2 impulse = c.manifold.normal * c.normalImpulse + perp(c.manifold.normal) * c.tangentImpulse;
+            this->apply(c, impulse);
+        }
+    }
+
+    void Arbiter::applyImpulse() {
+
+        for (Contact& c : this->contacts) {
+
+            glm::vec2 normal = c.manifold.normal;
+            glm::vec2 tangent = perp(normal);
+
+            // Clamp the accumulated normal impulse rather than each increment, so later iterations can undo earlier ones.
+            float vn = glm::dot(this->relativeVelocity(c), normal);
+            float previous = c.normalImpulse;
+            c.normalImpulse = std::max(previous + c.normalMass * (c.bias - vn), 0.0f);
+            this->apply(c, normal * (c.normalImpulse - previous));
+
+            // Friction is bounded by the normal impulse accumulated so far.
+            if (this->friction <= 0.0f) {continue;}
+            float vt = glm::dot(this->relativeVelocity(c), tangent);
+            float limit = this->friction * c.normalImpulse;
+            previous = c.tangentImpulse;
+            c.tangentImpulse = std::max(-limit, std::min(previous - c.tangentMass * vt, limit));
+            this->apply(c, tangent * (c.tangentImpulse - previous));
+
+        }
+
+    }
+
+    void Arbiter::correctPositions() {
+
+        const float slop = 0.01f;
+        const float percent = 0.4f;
+
+        float invMassA = this->inverseMassA;
+        float invMassB = this->inverseMassB;
+        bool infiniteA = invMassA == 0.0f;
+        bool infiniteB = invMassB == 0.0f;
+
+        float depthTotal = 0.0f;
+        for (const Contact& c : this->contacts) {depthTotal += c.manifold.depth;}
+        if (depthTotal <= 0.0f) {return;}
+
+        // Push the bodies apart once per step, weighting each contact by its share of the total depth.
+        glm::vec2 aPosition = glm::vec2(0.0f, 0.0f);
+        glm::vec2 bPosition = glm::vec2(0.0f, 0.0f);
+        for (const Contact& c : this->contacts) {
+
+            const CollisionManifold& m = c.manifold;
+            float weight = m.depth / depthTotal;
+
+            if (!infiniteA && !infiniteB) {
+                glm::vec2 correction = std::max(m.depth - slop, 0.0f) / (invMassA + invMassB) * percent * m.normal;
+                aPosition -= correction * invMassA * weight;
+                bPosition += correction * invMassB * weight;
+            }
+
+            if (infiniteB) {aPosition -= m.depth * m.normal * weight;}
+            if (infiniteA) {bPosition += m.depth * m.normal * weight;}
+
+        }
+
+        if (!infiniteA) {this->a->getEntity()->addPosition(aPosition);}
+        if (!infiniteB) {this->b->getEntity()->addPosition(bPosition);}
+
+    }
+
+}
@@ -0,0 +1,124 @@
+#include "pancake/physics/bodies.hpp"
+#include "pancake/physics/rigidbody.hpp"
+
+namespace Pancake {
+
+    int BodyStore::size() {
+        return this->rigidbodies.size();
+    }
+
+    Rigidbody* BodyStore::get(int body) {
+        return this->rigidbodies[body];
+    }
+
+    int BodyStore::add(Rigidbody* rigidbody) {
+
+        glm::vec2 velocity = rigidbody->getVelocity();
+        glm::vec2 force = rigidbody->getForce();
+
+        this->rigidbodies.push_back(rigidbody);
+        this->massDirty.push_back(true);
+        this->velocityX.push_back(velocity.x);
+        this->velocityY.push_back(velocity.y);
+        this->angularVelocity.push_back(rigidbody->getAngularVelocity());
+        this->forceX.push_back(force.x);
+        this->forceY.push_back(force.y);
+        this->torque.push_back(rigidbody->getTorque());
+        this->inverseMass.push_back(0.0f);
+        this->inverseMoment.push_back(0.0f);
+
+        int body = this->rigidbodies.size() - 1;
+        rigidbody->setBody(this, body);
+        return body;
+
+    }
+
+    void BodyStore::remove(int body) {
+
+        this->rigidbodies[body]->setBody(nullptr, -1);
+
+        this->rigidbodies.erase(this->rigidbodies.begin() + body);
+        this->massDirty.erase(this->massDirty.begin() + body);
+        this->velocityX.erase(this->velocityX.begin() + body);
+        this->velocityY.erase(this->velocityY.begin() + body);
+        this->angularVelocity.erase(this->angularVelocity.begin() + body);
+        this->forceX.erase(this->forceX.begin() + body);
+        this->forceY.erase(this->forceY.begin() + body);
+        this->torque.erase(this->torque.begin() + body);
+        this->inverseMass.erase(this->inverseMass.begin() + body);
+        this->inverseMoment.erase(this->inverseMoment.begin() + body);
+
+        // Every rigidbody after the removed one has moved down a slot.
+        int n = this->rigidbodies.size();
+        for (int i = body; i < n; i++) {this->rigidbodies[i]->setBody(this, i);}
+
+    }
+
+    glm::vec2 BodyStore::getVelocity(int body) {
+        return glm::vec2(this->velocityX[body], this->velocityY[body]);
+    }
+
+    glm::vec2 BodyStore::getForce(int body) {
+        return glm::vec2(this->forceX[body], this->forceY[body]);
+    }
+
+    void BodyStore::setVelocity(int body, glm::vec2 velocity) {
+        this->velocityX[body] = velocity.x;
+        this->velocityY[body] = velocity.y;
+    }
+
+    void BodyStore::setForce(int body, glm::vec2 force) {
+        this->forceX[body] = force.x;
+        this->forceY[body] = force.y;
+    }
+
+    void BodyStore::setMassDirty(int body) {
+        this->massDirty[body] = true;
+    }
+
+    void BodyStore::updateMasses() {
+
+        int n = this->rigidbodies.size();
+        for (int i = 0; i < n; i++) {
+
+            if (!this->massDirty[i]) {continue;}
+            this->massDirty[i] = false;
+
+            // Static and fixed bodies are given no velocity, so the solver can read the arrays directly.
+            Rigidbody* rigidbody = this->rigidbodies[i];
+            bool infinite = rigidbody->hasInfiniteMass();
+            this->inverseMass[i] = rigidbody->getInverseMass();
+            this->inverseMoment[i] = infinite || rigidbody->hasFixedOrientation() ? 0.0f : rigidbody->getInverseMomentOfInertia();
+            if (infinite) {this->velocityX[i] = 0.0f; this->velocityY[i] = 0.0f;}
+            if (this->inverseMoment[i] == 0.0f) {this->angularVelocity[i] = 0.0f;}
+
+        }
+
+    }
+
+    void BodyStore::integrateForces(float dt) {
+
+        // Sleeping rigidbodies have no accumulated force and static ones have no inverse mass, so every
+        // body can go through the same branchless loop.
+        int n = this->rigidbodies.size();
+        float* vx = this->velocityX.data();
+        float* vy = this->velocityY.data();
+        float* w = this->angularVelocity.data();
+        float* fx = this->forceX.data();
+        float* fy = this->forceY.data();
+        float* t = this->torque.data();
+        const float* im = this->inverseMass.data();
+        const float* ii = this->inverseMoment.data();
+
+        for (int i = 0; i < n; i++) {
+            vx[i] += fx[i] * im[i] * dt;
+            vy[i] += fy[i] * im[i] * dt;
+            w[i] += t[i] * ii[i] * dt;
+            fx[i] = 0.0f;
+            fy[i] = 0.0f;
+            t[i] = 0.0f;
+        }
+
+    }
+
+}
@@ -0,0 +1,349 @@
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <iostream>
+#include "pancake/physics/broadphase.hpp"
+#include "pancake/physics/rigidbody.hpp"
+
+namespace Pancake {
+
+    namespace {
+
+        // Pairs whose layers and masks rule out a collision are dropped before they reach the narrowphase.
+        bool canCollide(Rigidbody* const& a, Rigidbody* const& b) {
+            return a->canCollide(b);
+        }
+
+    }
+
+    Broadphase::Broadphase(std::string type) {
+        this->type = type;
+    }
+
+    Broadphase::~Broadphase() {
+
+    }
+
+    json Broadphase::serialise() {
+        json j;
+        j.emplace("type", this->type);
+        return j;
+    }
+
+    bool Broadphase::load(json j) {
+        if (!j.contains("type") || !j["type"].is_string()) {return false;}
+        return true;
+    }
+
+    std::string Broadphase::getType() {
+        return this->type;
+    }
+
+    void Broadphase::prepare() {
+
+    }
+
+    SpatialHashBroadphase::SpatialHashBroadphase() : Broadphase("SpatialHashBroadphase") {
+        this->grid = new SpatialHashGrid<Rigidbody*>(4);
+    }
+
+    SpatialHashBroadphase::~SpatialHashBroadphase() {
+        delete this->grid;
+    }
+
+    json SpatialHashBroadphase::serialise() {
+        json j = this->Broadphase::serialise();
+        j.emplace("gridSize", this->grid->getGridSize());
+        return j;
+    }
+
+    bool SpatialHashBroadphase::load(json j) {
+        if (!this->Broadphase::load(j)) {return false;}
+        if (!j.contains("gridSize") || !j["gridSize"].is_number_integer()) {return false;}
+        if (j["gridSize"] < 1) {return false;}
+        this->setGridSize(j["gridSize"]);
+        return true;
+    }
+
+    int SpatialHashBroadphase::getGridSize() {
+        return this->grid->getGridSize();
+    }
+
+    SpatialHashBroadphase* SpatialHashBroadphase::setGridSize(int gridSize) {
+        if (gridSize < 1) {
+            std::cout << "ERROR::SPATIAL_HASH_BROADPHASE::SET_GRID_SIZE::INVALID_GRID_SIZE: " << gridSize << "\n";
+            return this;
+        }
+        // Registered rigidbodies are kept and re-binned into the new cells.
+        this->grid->setGridSize(gridSize);
+        return this;
+    }
+
+    void SpatialHashBroadphase::add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) {
+        this->grid->add(rigidbody, min, max);
+    }
+
+    void SpatialHashBroadphase::update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) {
+        this->grid->update(rigidbody, min, max);
+    }
+
+    void SpatialHashBroadphase::remove(Rigidbody* rigidbody) {
+        this->grid->remove(rigidbody);
+    }
+
+    void SpatialHashBroadphase::clear() {
+        this->grid->clear();
+    }
+
+    void SpatialHashBroadphase::pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) {
+        this->grid->pairs(result, canCollide);
+    }
+
+    void SpatialHashBroadphase::query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) {
+        this->grid->query(min, max, result);
+    }
+
+    void SpatialHashBroadphase::raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) {
+        this->grid->raycast(origin, direction, distance, callback);
+    }
+
+    void SpatialHashBroadphase::prepare() {
+        this->grid->prepare();
+    }
+
+    namespace {
+
+        // Minimum endpoints sort before maximum endpoints at the same position, so touching bounds overlap.
+        template<class E>
+        bool precedes(const E& a, const E& b) {
+            return a.value < b.value || (a.value == b.value && a.isMin && !b.isMin);
+        }
+
+    }
+
+    SweepAndPruneBroadphase::SweepAndPruneBroadphase() : Broadphase("SweepAndPruneBroadphase") {
+        this->sortedEndpoints = 0;
+        this->removed = false;
+    }
+
+    void SweepAndPruneBroadphase::add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) {
+
+        auto it = this->index.find(rigidbody);
+        if (it != this->index.end()) {this->update(rigidbody, min, max); return;}
+
+        // Reuse a proxy slot if one is free.
+        int proxy;
+        if (!this->freeProxies.empty()) {
+            proxy = this->freeProxies.back();
+            this->freeProxies.pop_back();
+            this->proxies[proxy] = {rigidbody, min, max, -1};
+        } else {
+            proxy = this->proxies.size();
+            this->proxies.push_back({rigidbody, min, max, -1});
+        }
+
+        // The new endpoints are appended after the sorted range and merged in on the next sort.
+        this->index.insert({rigidbody, proxy});
+        this->endpoints.push_back({min.x, proxy, true});
+        this->endpoints.push_back({max.x, proxy, false});
+
+    }
+
+    void SweepAndPruneBroadphase::update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) {
+        auto it = this->index.find(rigidbody);
+        if (it == this->index.end()) {this->add(rigidbody, min, max); return;}
+        Proxy& proxy = this->proxies[it->second];
+        proxy.min = min;
+        proxy.max = max;
+    }
+
+    void SweepAndPruneBroadphase::remove(Rigidbody* rigidbody) {
+
+        auto it = this->index.find(rigidbody);
+        if (it == this->index.end()) {return;}
+
+        // The proxy's endpoints are dropped and its slot freed on the next sort.
+        this->proxies[it->second].rigidbody = nullptr;
+        this->index.erase(it);
+        this->removed = true;
+
+    }
+
+    void SweepAndPruneBroadphase::clear() {
+        this->proxies.clear();
+        this->freeProxies.clear();
+        this->index.clear();
+        this->endpoints.clear();
+        this->activeProxies.clear();
+        this->sortedEndpoints = 0;
+        this->removed = false;
+    }
+
+    void SweepAndPruneBroadphase::sort() {
+
+        // Drop the endpoints of removed proxies, keeping track of how many remain in the sorted range.
+        if (this->removed) {
+
+            int n = this->endpoints.size();
+            int kept = 0;
+            int sorted = 0;
+            for (int i = 0; i < n; i++) {
+                const Endpoint& e = this->endpoints[i];
+                if (this->proxies[e.proxy].rigidbody == nullptr) {
+                    if (e.isMin) {this->freeProxies.push_back(e.proxy);}
+                    continue;
+                }
+                if (i < this->sortedEndpoints) {sorted++;}
+                this->endpoints[kept] = e;
+                kept++;
+            }
+
+            this->endpoints.resize(kept);
+            this->sortedEndpoints = sorted;
+            this->removed = false;
+
+        }
+
+        // Refresh the endpoint positions from the proxies.
+        for (Endpoint& e : this->endpoints) {
+            const Proxy& p = this->proxies[e.proxy];
+            e.value = e.isMin ? p.min.x : p.max.x;
+        }
+
+        // Insertion sort the previously sorted range, bodies move little between steps so this is close to linear.
+        for (int i = 1; i < this->sortedEndpoints; i++) {
+            Endpoint e = this->endpoints[i];
+            int j = i - 1;
+            while (j >= 0 && precedes(e, this->endpoints[j])) {
+                this->endpoints[j + 1] = this->endpoints[j];
+                j--;
+            }
+            this->endpoints[j + 1] = e;
+        }
+
+        // Sort any newly added endpoints separately and merge them in.
+        if (this->sortedEndpoints < (int) this->endpoints.size()) {
+            auto middle = this->endpoints.begin() + this->sortedEndpoints;
+            std::sort(middle, this->endpoints.end(), precedes<Endpoint>);
+            std::inplace_merge(this->endpoints.begin(), middle, this->endpoints.end(), precedes<Endpoint>);
+            this->sortedEndpoints = this->endpoints.size();
+        }
+
+    }
+
+    void SweepAndPruneBroadphase::pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) {
+
+        this->sort();
+
+        // Sweep along x, every proxy opened while another is still open overlaps it on x.
+        this->activeProxies.clear();
+        for (const Endpoint& e : this->endpoints) {
+
+            Proxy& p = this->proxies[e.proxy];
+
+            if (e.isMin) {
+
+                for (int other : this->activeProxies) {
+                    const Proxy& q = this->proxies[other];
+                    if (p.max.y < q.min.y || q.max.y < p.min.y) {continue;}
+                    if (!canCollide(q.rigidbody, p.rigidbody)) {continue;}
+                    result.push_back(std::make_pair(q.rigidbody, p.rigidbody));
+                }
+
+                p.active = this->activeProxies.size();
+                this->activeProxies.push_back(e.proxy);
+
+            }
+
+            else {
+                int last = this->activeProxies.back();
+                this->activeProxies[p.active] = last;
+                this->proxies[last].active = p.active;
+                this->activeProxies.pop_back();
+            }
+
+        }
+
+    }
+
+    void SweepAndPruneBroadphase::query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) {
+        for (const Proxy& p : this->proxies) {
+            if (p.rigidbody == nullptr) {continue;}
+            if (p.max.x < min.x || max.x < p.min.x || p.max.y < min.y || max.y < p.min.y) {continue;}
+            result.push_back(p.rigidbody);
+        }
+    }
+
+    void SweepAndPruneBroadphase::raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) {
+        for (const Proxy& p : this->proxies) {
+            if (p.rigidbody == nullptr) {continue;}
+            float t = raycastBounds(origin, direction, p.min, p.max);
+            if (t < 0.0f || t > distance) {continue;}
+            distance = std::min(distance, callback(p.rigidbody));
+        }
+    }
+
+    DynamicTreeBroadphase::DynamicTreeBroadphase() : Broadphase("DynamicTreeBroadphase") {
+        this->tree = new DynamicTree<Rigidbody*>(0.1f);
+    }
+
+    DynamicTreeBroadphase::~DynamicTreeBroadphase() {
+        delete this->tree;
+    }
+
+    json DynamicTreeBroadphase::serialise() {
+        json j = this->Broadphase::serialise();
+        j.emplace("margin", this->tree->getMargin());
+        return j;
+    }
+
+    bool DynamicTreeBroadphase::load(json j) {
+        if (!this->Broadphase::load(j)) {return false;}
+        if (!j.contains("margin") || !j["margin"].is_number()) {return false;}
+        this->setMargin(j["margin"]);
+        return true;
+    }
+
+    float DynamicTreeBroadphase::getMargin() {
+        return this->tree->getMargin();
+    }
+
+    DynamicTreeBroadphase* DynamicTreeBroadphase::setMargin(float margin) {
+        if (!std::isfinite(margin)) {
+            std::cout << "ERROR::DYNAMIC_TREE_BROADPHASE::SET_MARGIN::INVALID_MARGIN: " << margin << "\n";
+            return this;
+        }
+        // Registered rigidbodies are kept and reinserted with the new margin.
+        this->tree->setMargin(margin);
+        return this;
+    }
+
+    void DynamicTreeBroadphase::add(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) {
+        this->tree->add(rigidbody, min, max);
+    }
+
+    void DynamicTreeBroadphase::update(Rigidbody* rigidbody, glm::vec2 min, glm::vec2 max) {
+        this->tree->update(rigidbody, min, max);
+    }
+
+    void DynamicTreeBroadphase::remove(Rigidbody* rigidbody) {
+        this->tree->remove(rigidbody);
+    }
+
+    void DynamicTreeBroadphase::clear() {
+        this->tree->clear();
+    }
+
+    void DynamicTreeBroadphase::pairs(std::vector<std::pair<Rigidbody*, Rigidbody*>>& result) {
+        this->tree->pairs(result, canCollide);
+    }
+
+    void DynamicTreeBroadphase::query(glm::vec2 min, glm::vec2 max, std::vector<Rigidbody*>& result) {
+        this->tree->query(min, max, result);
+    }
+
+    void DynamicTreeBroadphase::raycast(glm::vec2 origin, glm::vec2 direction, float distance, std::function<float(Rigidbody*)> callback) {
+        this->tree->raycast(origin, direction, distance, callback);
+    }
+
+}
\ No newline at end of file
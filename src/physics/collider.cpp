@@ -1,4 +1,5 @@
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include "pancake/physics/collider.hpp"
@@ -7,6 +8,10 @@ namespace Pancake {
 
     namespace {
 
+        float cross(vec2 a, vec2 b) {
+            return a.x * b.y - a.y * b.x;
+        }
+
         void rotateVector(vec2& vec, vec2 origin, float rCos, float rSin) {
             float x = vec.x - origin.x;
             float y = vec.y - origin.y;
@@ -24,7 +29,8 @@ namespace Pancake {
         this->rotationOffset = rotationOffset;
     }
 
-    Collider::Collider(std::string type) {
+    Collider::Collider(std::string type, ColliderShape shape) {
+        this->shape = shape;
         this->init(type, 0.0f, glm::vec2(0.0f, 0.0f), 0.0f);
     }
 
@@ -71,6 +77,10 @@ namespace Pancake {
         return this->type;
     }
 
+    ColliderShape Collider::getShape() {
+        return this->shape;
+    }
+
     Rigidbody* Collider::getRigidbody() {
         return this->rigidbody;
     }
@@ -181,7 +191,7 @@ namespace Pancake {
         return this;
     }
 
-    BoxCollider::BoxCollider() : Collider("BoxCollider")  {
+    BoxCollider::BoxCollider() : Collider("BoxCollider", BOX_COLLIDER) {
         this->size = glm::vec2(1.0f, 1.0f);
     }
 
@@ -267,7 +277,7 @@ namespace Pancake {
         return this->setSize(glm::vec2(w, h));
     }
 
-    CircleCollider::CircleCollider() : Collider("CircleCollider") {
+    CircleCollider::CircleCollider() : Collider("CircleCollider", CIRCLE_COLLIDER) {
         this->radius = 0.5f;
     }
 
@@ -309,4 +319,440 @@ namespace Pancake {
 
     }
 
+    PolygonCollider::PolygonCollider() : Collider("PolygonCollider", POLYGON_COLLIDER) {
+        this->vertices = {vec2(-0.5f, -0.5f), vec2(0.5f, -0.5f), vec2(0.5f, 0.5f), vec2(-0.5f, 0.5f)};
+    }
+
+    json PolygonCollider::serialise() {
+
+        json j = this->Collider::serialise();
+
+        j.emplace("vertices", json::array());
+        for (vec2 v : this->vertices) {
+            json vertex = json::array();
+            vertex.push_back(v.x);
+            vertex.push_back(v.y);
+            j["vertices"].push_back(vertex);
+        }
+
+        return j;
+
+    }
+
+    bool PolygonCollider::load(json j) {
+
+        if (!this->Collider::load(j)) {return false;}
+
+        if (!j.contains("vertices") || !j["vertices"].is_array()) {return false;}
+        if (j["vertices"].size() < 3 || j["vertices"].size() > MAX_POLYGON_VERTICES) {return false;}
+
+        std::vector<vec2> vertices;
+        for (auto& element : j["vertices"]) {
+            if (!element.is_array() || element.size() != 2) {return false;}
+            if (!element[0].is_number() || !element[1].is_number()) {return false;}
+            vertices.push_back(vec2(element[0], element[1]));
+        }
+
+        return this->buildHull(vertices);
+
+    }
+
+    float PolygonCollider::getMomentOfInertia() {
+
+        if (this->getMass() <= 0.0f) {return FLT_MAX;}
+
+        // Sum the triangles fanned out from the collider's position, weighted by their signed area. Triangles
+        // outside the hull are cancelled out, so the position does not need to be inside it.
+        float numerator = 0.0f;
+        float denominator = 0.0f;
+        int n = this->vertices.size();
+        for (int i = 0; i < n; i++) {
+            vec2 a = this->vertices[i];
+            vec2 b = this->vertices[(i + 1) % n];
+            float area = cross(a, b);
+            numerator += area * (glm::dot(a, a) + glm::dot(a, b) + glm::dot(b, b));
+            denominator += area;
+        }
+
+        if (denominator <= 0.0f) {return FLT_MAX;}
+        return this->getMass() * numerator / (6.0f * denominator);
+
+    }
+
+    std::pair<glm::vec2, glm::vec2> PolygonCollider::getLocalBounds() {
+
+        float r = this->getRotation();
+        float c = cosf(r);
+        float s = sinf(r);
+
+        glm::vec2 min = glm::vec2(FLT_MAX, FLT_MAX);
+        glm::vec2 max = glm::vec2(-FLT_MAX, -FLT_MAX);
+        for (vec2 v : this->vertices) {
+            rotateVector(v, glm::vec2(0.0f, 0.0f), c, s);
+            min = glm::min(min, v);
+            max = glm::max(max, v);
+        }
+
+        return std::make_pair(min, max);
+
+    }
+
+    std::vector<glm::vec2> PolygonCollider::getVertices() {
+        return this->vertices;
+    }
+
+    PolygonCollider* PolygonCollider::setVertices(std::vector<glm::vec2> vertices) {
+        this->buildHull(vertices);
+        return this;
+    }
+
+    bool PolygonCollider::buildHull(std::vector<glm::vec2> vertices) {
+
+        // Build the hull with a monotone chain, which leaves it anticlockwise without repeated or collinear points.
+        std::sort(vertices.begin(), vertices.end(), [](const vec2& a, const vec2& b) {return a.x < b.x || (a.x == b.x && a.y < b.y);});
+        std::vector<vec2> hull(2 * vertices.size());
+        int k = 0;
+        for (int i = 0; i < (int) vertices.size(); i++) {
+            while (k >= 2 && cross(hull[k - 1] - hull[k - 2], vertices[i] - hull[k - 2]) <= 0.0f) {k--;}
+            hull[k++] = vertices[i];
+        }
+        for (int i = vertices.size() - 2, lower = k + 1; i >= 0; i--) {
+            while (k >= lower && cross(hull[k - 1] - hull[k - 2], vertices[i] - hull[k - 2]) <= 0.0f) {k--;}
+            hull[k++] = vertices[i];
+        }
+        hull.resize(std::max(k - 1, 0));
+
+        if (hull.size() < 3) {
+            std::cout << "ERROR::POLYGON_COLLIDER::SET_VERTICES::DEGENERATE_POLYGON\n";
+            return false;
+        }
+
+        if (hull.size() > MAX_POLYGON_VERTICES) {
+            std::cout << "ERROR::POLYGON_COLLIDER::SET_VERTICES::TOO_MANY_VERTICES\n";
+            return false;
+        }
+
+        if (this->getRigidbody() != nullptr) {
+            this->getRigidbody()->setBoundsDirty();
+            this->getRigidbody()->setMomentDirty();
+        }
+
+        this->vertices = hull;
+        return true;
+
+    }
+
+    CapsuleCollider::CapsuleCollider() : Collider("CapsuleCollider", CAPSULE_COLLIDER) {
+        this->length = 1.0f;
+        this->radius = 0.5f;
+    }
+
+    json CapsuleCollider::serialise() {
+        json j = this->Collider::serialise();
+        j.emplace("length", this->length);
+        j.emplace("radius", this->radius);
+        return j;
+    }
+
+    bool CapsuleCollider::load(json j) {
+        if (!this->Collider::load(j)) {return false;}
+        if (!j.contains("length") || !j["length"].is_number()) {return false;}
+        if (!j.contains("radius") || !j["radius"].is_number()) {return false;}
+        this->setLength(j["length"]);
+        this->setRadius(j["radius"]);
+        return true;
+    }
+
+    float CapsuleCollider::getMomentOfInertia() {
+
+        if (this->getMass() <= 0.0f) {return FLT_MAX;}
+
+        // Split the mass between the middle box and the two semicircular ends by area.
+        float r = this->radius;
+        float l = this->length;
+        float boxArea = 2.0f * r * l;
+        float circleArea = 3.14159265359f * r * r;
+        float boxMass = this->getMass() * boxArea / (boxArea + circleArea);
+        float circleMass = this->getMass() - boxMass;
+
+        // Each end is moved out to its place along the axis from its own centre of mass.
+        float offset = 4.0f * r / (3.0f * 3.14159265359f);
+        float box = boxMass * (l * l + 4.0f * r * r) / 12.0f;
+        float ends = circleMass * (0.5f * r * r + 0.25f * l * l + l * offset);
+        return box + ends;
+
+    }
+
+    std::pair<glm::vec2, glm::vec2> CapsuleCollider::getLocalBounds() {
+
+        // The end centres, swept out by the radius.
+        float r = this->getRotation();
+        glm::vec2 end = glm::vec2(cosf(r), sinf(r)) * this->length * 0.5f;
+        end.x = std::abs(end.x) + this->radius;
+        end.y = std::abs(end.y) + this->radius;
+
+        return std::make_pair(-end, end);
+
+    }
+
+    float CapsuleCollider::getLength() {
+        return this->length;
+    }
+
+    float CapsuleCollider::getRadius() {
+        return this->radius;
+    }
+
+    CapsuleCollider* CapsuleCollider::setLength(float length) {
+
+        if (this->getRigidbody() != nullptr) {
+            this->getRigidbody()->setBoundsDirty();
+            this->getRigidbody()->setMomentDirty();
+        }
+
+        this->length = std::max(length, 0.0f);
+        return this;
+
+    }
+
+    CapsuleCollider* CapsuleCollider::setRadius(float radius) {
+
+        if (this->getRigidbody() != nullptr) {
+            this->getRigidbody()->setBoundsDirty();
+            this->getRigidbody()->setMomentDirty();
+        }
+
+        this->radius = radius;
+        return this;
+
+    }
+
+    TilemapCollider::TilemapCollider() : Collider("TilemapCollider", TILEMAP_COLLIDER) {
+        this->width = 0;
+        this->height = 0;
+        this->tileSize = glm::vec2(1.0f, 1.0f);
+        this->builtFor = nullptr;
+        this->builtOffset = glm::vec2(0.0f, 0.0f);
+        this->dirty = true;
+    }
+
+    TilemapCollider::~TilemapCollider() {
+        for (BoxCollider* box : this->boxes) {delete box;}
+    }
+
+    json TilemapCollider::serialise() {
+
+        json j = this->Collider::serialise();
+
+        j.emplace("width", this->width);
+        j.emplace("height", this->height);
+
+        j.emplace("tileSize", json::array());
+        j["tileSize"].push_back(this->tileSize.x);
+        j["tileSize"].push_back(this->tileSize.y);
+
+        j.emplace("tiles", json::array());
+        for (unsigned char tile : this->tiles) {j["tiles"].push_back(tile != 0 ? 1 : 0);}
+
+        return j;
+
+    }
+
+    bool TilemapCollider::load(json j) {
+
+        if (!this->Collider::load(j)) {return false;}
+
+        if (!j.contains("width") || !j["width"].is_number_integer()) {return false;}
+        if (!j.contains("height") || !j["height"].is_number_integer()) {return false;}
+
+        if (!j.contains("tileSize") || !j["tileSize"].is_array()) {return false;}
+        if (j["tileSize"].size() != 2) {return false;}
+        if (!j["tileSize"][0].is_number()) {return false;}
+        if (!j["tileSize"][1].is_number()) {return false;}
+
+        int width = j["width"];
+        int height = j["height"];
+        if (width < 0 || height < 0) {return false;}
+        if (!j.contains("tiles") || !j["tiles"].is_array()) {return false;}
+        if (j["tiles"].size() != (size_t) width * height) {return false;}
+        for (auto& tile : j["tiles"]) {
+            if (!tile.is_number_integer()) {return false;}
+        }
+
+        this->setSize(width, height);
+        this->setTileSize(glm::vec2(j["tileSize"][0], j["tileSize"][1]));
+        for (int i = 0; i < width * height; i++) {
+            int tile = j["tiles"][i];
+            this->tiles[i] = tile != 0 ? 1 : 0;
+        }
+
+        return true;
+
+    }
+
+    void TilemapCollider::setDirty() {
+
+        if (this->getRigidbody() != nullptr) {
+            this->getRigidbody()->setBoundsDirty();
+            this->getRigidbody()->setMomentDirty();
+        }
+
+        this->dirty = true;
+
+    }
+
+    void TilemapCollider::rebuild() {
+
+        // The boxes are placed relative to the rigidbody, so they are moved along with the collider's offset.
+        if (!this->dirty && this->builtFor == this->getRigidbody() && this->builtOffset == this->getPositionOffset()) {return;}
+
+        for (BoxCollider* box : this->boxes) {delete box;}
+        this->boxes.clear();
+        this->rectangles.clear();
+        this->owners.assign(this->tiles.size(), -1);
+
+        // Grow each box right along the row from the first unclaimed solid tile, then up for as long as the rows
+        // above are solid and unclaimed along its whole width.
+        for (int y = 0; y < this->height; y++) {
+            for (int x = 0; x < this->width; x++) {
+
+                int start = y * this->width + x;
+                if (this->tiles[start] == 0 || this->owners[start] != -1) {continue;}
+
+                int w = 1;
+                while (x + w < this->width && this->tiles[start + w] != 0 && this->owners[start + w] == -1) {w++;}
+
+                int h = 1;
+                while (y + h < this->height) {
+                    int row = (y + h) * this->width + x;
+                    bool solid = true;
+                    for (int i = 0; i < w && solid; i++) {solid = this->tiles[row + i] != 0 && this->owners[row + i] == -1;}
+                    if (!solid) {break;}
+                    h++;
+                }
+
+                int index = this->rectangles.size();
+                for (int j = y; j < y + h; j++) {
+                    for (int i = x; i < x + w; i++) {this->owners[j * this->width + i] = index;}
+                }
+                this->rectangles.push_back({x, y, w, h});
+
+                BoxCollider* box = new BoxCollider();
+                glm::vec2 size = glm::vec2(w, h) * this->tileSize;
+                box->setSize(size);
+                box->setPositionOffset(this->getPositionOffset() + glm::vec2(x, y) * this->tileSize + size * 0.5f, false);
+                box->setRigidbody(this->getRigidbody());
+                this->boxes.push_back(box);
+
+            }
+        }
+
+        this->builtFor = this->getRigidbody();
+        this->builtOffset = this->getPositionOffset();
+        this->dirty = false;
+
+    }
+
+    bool TilemapCollider::isBuilt() {
+        if (this->dirty || this->builtFor != this->getRigidbody() || this->builtOffset != this->getPositionOffset()) {return false;}
+        return this->owners.size() == (size_t) this->width * this->height;
+    }
+
+    void TilemapCollider::prepare() {
+        this->rebuild();
+    }
+
+    float TilemapCollider::getMomentOfInertia() {
+
+        if (this->getMass() <= 0.0f) {return FLT_MAX;}
+        this->rebuild();
+
+        // Share the mass between the boxes by area, and move each out to its place from the collider's position.
+        float area = 0.0f;
+        for (const Rectangle& r : this->rectangles) {area += r.width * r.height;}
+        if (area <= 0.0f) {return FLT_MAX;}
+
+        float moment = 0.0f;
+        for (const Rectangle& r : this->rectangles) {
+            float mass = this->getMass() * r.width * r.height / area;
+            glm::vec2 size = glm::vec2(r.width, r.height) * this->tileSize;
+            glm::vec2 centre = glm::vec2(r.x, r.y) * this->tileSize + size * 0.5f;
+            moment += mass * (glm::dot(size, size) / 12.0f + glm::dot(centre, centre));
+        }
+
+        return moment;
+
+    }
+
+    std::pair<glm::vec2, glm::vec2> TilemapCollider::getLocalBounds() {
+        this->rebuild();
+        return std::make_pair(glm::vec2(0.0f, 0.0f), glm::vec2(this->width, this->height) * this->tileSize);
+    }
+
+    int TilemapCollider::getWidth() {
+        return this->width;
+    }
+
+    int TilemapCollider::getHeight() {
+        return this->height;
+    }
+
+    glm::vec2 TilemapCollider::getTileSize() {
+        return this->tileSize;
+    }
+
+    bool TilemapCollider::isSolid(int x, int y) {
+        if (x < 0 || y < 0 || x >= this->width || y >= this->height) {return false;}
+        return this->tiles[y * this->width + x] != 0;
+    }
+
+    int TilemapCollider::getBoxCount() {
+        this->rebuild();
+        return this->boxes.size();
+    }
+
+    BoxCollider* TilemapCollider::getBox(int index) {
+        this->rebuild();
+        return this->boxes[index];
+    }
+
+    TilemapCollider* TilemapCollider::setSize(int width, int height) {
+
+        // Keep the tiles that are still inside the map.
+        std::vector<unsigned char> tiles((size_t) std::max(width, 0) * std::max(height, 0), 0);
+        for (int y = 0; y < std::min(height, this->height); y++) {
+            for (int x = 0; x < std::min(width, this->width); x++) {tiles[y * width + x] = this->tiles[y * this->width + x];}
+        }
+
+        this->width = std::max(width, 0);
+        this->height = std::max(height, 0);
+        this->tiles = tiles;
+        this->setDirty();
+        return this;
+
+    }
+
+    TilemapCollider* TilemapCollider::setTileSize(glm::vec2 size) {
+        this->tileSize = size;
+        this->setDirty();
+        return this;
+    }
+
+    TilemapCollider* TilemapCollider::setTileSize(float w, float h) {
+        return this->setTileSize(glm::vec2(w, h));
+    }
+
+    TilemapCollider* TilemapCollider::setSolid(int x, int y, bool solid) {
+
+        if (x < 0 || y < 0 || x >= this->width || y >= this->height) {
+            std::cout << "ERROR::TILEMAP_COLLIDER::SET_SOLID::OUT_OF_RANGE\n";
+            return this;
+        }
+
+        this->tiles[y * this->width + x] = solid ? 1 : 0;
+        this->setDirty();
+        return this;
+
+    }
+
 }
\ No newline at end of file
@@ -8,7 +8,9 @@
 #include "pancake/physics/collider.hpp"
 #include "pancake/physics/collision.hpp"
 
-using std::vector;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace Pancake {
 
@@ -37,8 +39,7 @@ namespace Pancake {
             vec.y = origin.y + ((x * rSin) + (y * rCos));
         }
 
-        void rotate(vector<vec2>& vertices, vec2 origin, float rCos, float rSin) {
-            int n = vertices.size();
+        void rotate(vec2* vertices, int n, vec2 origin, float rCos, float rSin) {
             for (int i = 0; i < n; i++) {
                 float x = vertices[i].x - origin.x;
                 float y = vertices[i].y - origin.y;
@@ -115,9 +116,10 @@ namespace Pancake {
 
         }
 
-        std::vector<CollisionManifold> findCollisionFeaturesCircleColliderAndCircleCollider(CircleCollider* a, CircleCollider* b) {
+        int findCollisionFeaturesCircleColliderAndCircleCollider(Collider* c1, Collider* c2, CollisionManifold* result) {
 
-            std::vector<CollisionManifold> result;
+            CircleCollider* a = (CircleCollider*) c1;
+            CircleCollider* b = (CircleCollider*) c2;
 
             vec2 aPosition = a->getPosition();
             vec2 bPosition = b->getPosition();
@@ -125,7 +127,7 @@ namespace Pancake {
             // Determine if the two circles are colliding.
             float sumRadii = a->getRadius() + b->getRadius();
             vec2 distance = bPosition - aPosition;
-            if (glm::dot(distance, distance) - (sumRadii * sumRadii) > 0) {return result;}
+            if (glm::dot(distance, distance) - (sumRadii * sumRadii) > 0) {return 0;}
 
             // Find the depth and normal of the collision
             float depth = fabsf(glm::length(distance) - sumRadii) * 0.5f;
@@ -135,14 +137,16 @@ namespace Pancake {
             float distanceToPoint = a->getRadius() - depth;
             vec2 point = distanceToPoint * normal + aPosition;
 
-            result.push_back(CollisionManifold(normal, point, depth));
-            return result;
+            result[0] = CollisionManifold(normal, point, depth);
+            return 1;
 
         }
 
-        std::vector<CollisionManifold> findCollisionFeaturesBoxColliderAndBoxCollider(BoxCollider* a, BoxCollider* b) {
+        int findCollisionFeaturesBoxColliderAndBoxCollider(Collider* c1, Collider* c2, CollisionManifold* result) {
 
-            std::vector<CollisionManifold> result;
+            BoxCollider* a = (BoxCollider*) c1;
+            BoxCollider* b = (BoxCollider*) c2;
+            int count = 0;
 
             // Store all the information that is required.
             float aRotation = a->getRotation();
@@ -164,22 +168,22 @@ namespace Pancake {
             float bSin = sinf(bRotation);
 
             // Get the vertices of a.
-            vector<vec2> aVertices;
-            aVertices.push_back(vec2(aMin.x, aMin.y)); // Bottom Left
-            aVertices.push_back(vec2(aMin.x, aMax.y)); // Top Left
-            aVertices.push_back(vec2(aMax.x, aMax.y)); // Top Right
-            aVertices.push_back(vec2(aMax.x, aMin.y)); // Bottom Right
-            rotate(aVertices, aPos, aCos, aSin);
-            rotate(aVertices, bPos, bCos, -bSin);
+            vec2 aVertices[4];
+            aVertices[0] = vec2(aMin.x, aMin.y); // Bottom Left
+            aVertices[1] = vec2(aMin.x, aMax.y); // Top Left
+            aVertices[2] = vec2(aMax.x, aMax.y); // Top Right
+            aVertices[3] = vec2(aMax.x, aMin.y); // Bottom Right
+            rotate(aVertices, 4, aPos, aCos, aSin);
+            rotate(aVertices, 4, bPos, bCos, -bSin);
 
             // Get the vertices of b.
-            vector<vec2> bVertices;
-            bVertices.push_back(vec2(bMin.x, bMin.y)); // Bottom Left
-            bVertices.push_back(vec2(bMin.x, bMax.y)); // Top Left
-            bVertices.push_back(vec2(bMax.x, bMax.y)); // Top Right
-            bVertices.push_back(vec2(bMax.x, bMin.y)); // Bottom Right
-            rotate(bVertices, bPos, bCos, bSin); // B Space -> Global
-            rotate(bVertices, aPos, aCos, -aSin);// Global -> A Space
+            vec2 bVertices[4];
+            bVertices[0] = vec2(bMin.x, bMin.y); // Bottom Left
+            bVertices[1] = vec2(bMin.x, bMax.y); // Top Left
+            bVertices[2] = vec2(bMax.x, bMax.y); // Top Right
+            bVertices[3] = vec2(bMax.x, bMin.y); // Bottom Right
+            rotate(bVertices, 4, bPos, bCos, bSin); // B Space -> Global
+            rotate(bVertices, 4, aPos, aCos, -aSin);// Global -> A Space
 
             // Get the positions of each box in their local spaces.
             vec2 aPosInB = aPos;
@@ -188,8 +192,8 @@ namespace Pancake {
             rotate(bPosInA, aPos, aCos, -aSin);
 
             // Determine which vertices of each box is in each others box.
-            vector<vec2> bInsideA; for (vec2 vertex : bVertices) {if (vertex.x > aMin.x && vertex.x < aMax.x && vertex.y > aMin.y && vertex.y < aMax.y) {bInsideA.push_back(vertex);}}
-            vector<vec2> aInsideB; for (vec2 vertex : aVertices) {if (vertex.x > bMin.x && vertex.x < bMax.x && vertex.y > bMin.y && vertex.y < bMax.y) {aInsideB.push_back(vertex);}}
+            vec2 bInsideA[4]; int bInsideCount = 0; for (vec2 vertex : bVertices) {if (vertex.x > aMin.x && vertex.x < aMax.x && vertex.y > aMin.y && vertex.y < aMax.y) {bInsideA[bInsideCount++] = vertex;}}
+            vec2 aInsideB[4]; int aInsideCount = 0; for (vec2 vertex : aVertices) {if (vertex.x > bMin.x && vertex.x < bMax.x && vertex.y > bMin.y && vertex.y < bMax.y) {aInsideB[aInsideCount++] = vertex;}}
 
             // Collision manifold variables.
             vec2 normal;
@@ -197,7 +201,7 @@ namespace Pancake {
             float depth;
 
             // Special case for 1 and 1.
-            if (aInsideB.size() == 1 && bInsideA.size() == 1) {
+            if (aInsideCount == 1 && bInsideCount == 1) {
                 
                 // Find which side of a is b.
                 vec2 other = aInsideB[0]; 
@@ -226,7 +230,7 @@ namespace Pancake {
                 rotate(point, aPos, aCos, aSin);
 
                 // Add the point to the manifold, if the depth is positive and non-zero.
-                depth *= 0.5f; if (depth > 0.0f) {result.push_back(CollisionManifold(normal, point, depth));}
+                depth *= 0.5f; if (depth > 0.0f) {result[count++] = CollisionManifold(normal, point, depth);}
                 
                 // Find which side of b is a.
                 other = bInsideA[0];
@@ -255,21 +259,21 @@ namespace Pancake {
                 rotate(point, bPos, bCos, bSin);
 
                 // Add the point to the manifold, if the depth is positive and non-zero.
-                depth *= 0.5f; if (depth > 0.0f) {result.push_back(CollisionManifold(-1.0f * normal, point, depth));}
-                return result;
+                depth *= 0.5f; if (depth > 0.0f) {result[count++] = CollisionManifold(-1.0f * normal, point, depth);}
+                return count;
 
             }
 
             // Flip the problem to reduce number of cases.
             bool flip = false;
-            if (aInsideB.size() > bInsideA.size()) {
+            if (aInsideCount > bInsideCount) {
                 flip = true; 
-                vector<vec2> tmp = bInsideA;
-                bInsideA = aInsideB; aInsideB = tmp; bVertices = aVertices;
+                for (int i = 0; i < 4; i++) {std::swap(bInsideA[i], aInsideB[i]); bVertices[i] = aVertices[i];}
+                std::swap(aInsideCount, bInsideCount);
                 aMax = bMax; aMin = bMin; aPos = bPos; aCos = bCos; aSin = bSin; 
             }
 
-            if (aInsideB.size() == 0 && bInsideA.size() == 1) {
+            if (aInsideCount == 0 && bInsideCount == 1) {
 
                 // Find the side that minimises the distance
                 float best = FLT_MAX;
@@ -284,12 +288,12 @@ namespace Pancake {
                 rotate(point, aPos, aCos, aSin);
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
 
             }
 
-            if (aInsideB.size() == 0 && bInsideA.size() == 2) {
+            if (aInsideCount == 0 && bInsideCount == 2) {
                 
                 // Collision manifold variables.
                 vec2 points[2];
@@ -298,10 +302,10 @@ namespace Pancake {
                 // Find the side that minimises the distance.
                 float best = FLT_MAX;
                 float current;
-                current = 0.0f; for (vec2 v : bInsideA) {current += aMax.y - v.y;} if (current < best) {normal = vec2( 0.0f,  1.0f); for (int i = 0; i < 2; i++) {depths[i] = (aMax.y - bInsideA[i].y) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Top
-                current = 0.0f; for (vec2 v : bInsideA) {current += v.y - aMin.y;} if (current < best) {normal = vec2( 0.0f, -1.0f); for (int i = 0; i < 2; i++) {depths[i] = (bInsideA[i].y - aMin.y) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Bottom
-                current = 0.0f; for (vec2 v : bInsideA) {current += aMax.x - v.x;} if (current < best) {normal = vec2( 1.0f,  0.0f); for (int i = 0; i < 2; i++) {depths[i] = (aMax.x - bInsideA[i].x) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Right
-                current = 0.0f; for (vec2 v : bInsideA) {current += v.x - aMin.x;} if (current < best) {normal = vec2(-1.0f,  0.0f); for (int i = 0; i < 2; i++) {depths[i] = (bInsideA[i].x - aMin.x) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Left
+                current = 0.0f; for (int i = 0; i < 2; i++) {current += aMax.y - bInsideA[i].y;} if (current < best) {normal = vec2( 0.0f,  1.0f); for (int i = 0; i < 2; i++) {depths[i] = (aMax.y - bInsideA[i].y) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Top
+                current = 0.0f; for (int i = 0; i < 2; i++) {current += bInsideA[i].y - aMin.y;} if (current < best) {normal = vec2( 0.0f, -1.0f); for (int i = 0; i < 2; i++) {depths[i] = (bInsideA[i].y - aMin.y) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Bottom
+                current = 0.0f; for (int i = 0; i < 2; i++) {current += aMax.x - bInsideA[i].x;} if (current < best) {normal = vec2( 1.0f,  0.0f); for (int i = 0; i < 2; i++) {depths[i] = (aMax.x - bInsideA[i].x) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Right
+                current = 0.0f; for (int i = 0; i < 2; i++) {current += bInsideA[i].x - aMin.x;} if (current < best) {normal = vec2(-1.0f,  0.0f); for (int i = 0; i < 2; i++) {depths[i] = (bInsideA[i].x - aMin.x) * 0.5f; points[i] = bInsideA[i] + normal * depths[i]; best = current;}} // Left
 
                 // Rotate back into global coordinates.
                 rotate(normal, vec2(0.0f, 0.0f), aCos, aSin);
@@ -309,18 +313,16 @@ namespace Pancake {
                 rotate(points[1], aPos, aCos, aSin);
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, points[0], depths[0] * 0.5f));
-                result.push_back(CollisionManifold(normal, points[1], depths[1] * 0.5f));
-                return result;
+                result[0] = CollisionManifold(normal, points[0], depths[0] * 0.5f);
+                result[1] = CollisionManifold(normal, points[1], depths[1] * 0.5f);
+                return 2;
 
             }
 
-            return result;
+            return 0;
         }
 
-        std::vector<CollisionManifold> findCollisionFeaturesCircleColliderAndBoxCollider(CircleCollider* c, BoxCollider* b, bool flip) {
-
-            std::vector<CollisionManifold> result;
+        int findCollisionFeaturesCircleColliderAndBoxCollider(CircleCollider* c, BoxCollider* b, bool flip, CollisionManifold* result) {
 
             // Get the circle's properties.
             vec2 cPos = c->getPosition();
@@ -358,8 +360,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -372,8 +374,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -386,8 +388,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -400,8 +402,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -416,8 +418,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -432,8 +434,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -448,8 +450,8 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
                 
             }
 
@@ -464,27 +466,696 @@ namespace Pancake {
                 if (bRot != 0.0f) {rotate(normal, vec2(0.0f, 0.0f), rCos, -rSin); rotate(point, bPos, rCos, -rSin);}
                 if (flip) {normal = -normal;}
 
-                result.push_back(CollisionManifold(normal, point, depth));
-                return result;
+                result[0] = CollisionManifold(normal, point, depth);
+                return 1;
 
             }
             
-            return result;
+            return 0;
+        }
+
+        int findCollisionFeaturesCircleColliderAndBoxCollider(Collider* c1, Collider* c2, CollisionManifold* result) {
+            return findCollisionFeaturesCircleColliderAndBoxCollider((CircleCollider*) c1, (BoxCollider*) c2, false, result);
+        }
+
+        int findCollisionFeaturesBoxColliderAndCircleCollider(Collider* c1, Collider* c2, CollisionManifold* result) {
+            return findCollisionFeaturesCircleColliderAndBoxCollider((CircleCollider*) c2, (BoxCollider*) c1, true, result);
+        }
+
+        // How much shallower a face of the second shape must be before it is used as the reference face
+        // instead of one of the first's, so the choice does not flicker between nearly equal faces.
+        const float REFERENCE_TOLERANCE = 0.0005f;
+
+        float cross(vec2 a, vec2 b) {
+            return a.x * b.y - a.y * b.x;
+        }
+
+        vec2 closestPoint(vec2 point, vec2 start, vec2 end) {
+            vec2 edge = end - start;
+            float length = glm::dot(edge, edge);
+            if (length <= 0.0f) {return start;}
+            float t = glm::dot(point - start, edge) / length;
+            if (t <= 0.0f) {return start;}
+            if (t >= 1.0f) {return end;}
+            return start + edge * t;
         }
 
+        // The largest gap between one of a's faces and all of b's vertices, and which face it is.
+        float findMaxSeparation(const RoundedPolygon& a, const RoundedPolygon& b, int& edge) {
+
+            float best = -FLT_MAX;
+            edge = 0;
+            if (a.count < 2) {return best;}
+
+            for (int i = 0; i < a.count; i++) {
+                float smallest = FLT_MAX;
+                for (int j = 0; j < b.count; j++) {smallest = std::min(smallest, glm::dot(b.vertices[j] - a.vertices[i], a.normals[i]));}
+                if (smallest > best) {best = smallest; edge = i;}
+            }
+
+            return best;
+
+        }
+
+        // The closest points between the outlines of two shapes, checking every vertex of each against every edge of
+        // the other. Returns whether the shapes are apart, which the separation along the faces does not always show
+        // when neither has any area.
+        bool findClosestPoints(const RoundedPolygon& a, const RoundedPolygon& b, float separation, vec2& pointA, vec2& pointB) {
+
+            if (separation <= 0.0f && (a.count > 2 || b.count > 2)) {return false;}
+
+            float best = FLT_MAX;
+            for (int i = 0; i < a.count; i++) {
+                vec2 start = a.vertices[i];
+                vec2 end = a.vertices[(i + 1) % a.count];
+                for (int j = 0; j < b.count; j++) {
+                    vec2 point = closestPoint(b.vertices[j], start, end);
+                    vec2 difference = b.vertices[j] - point;
+                    float distance = glm::dot(difference, difference);
+                    if (distance < best) {best = distance; pointA = point; pointB = b.vertices[j];}
+                }
+            }
+            for (int j = 0; j < b.count; j++) {
+                vec2 start = b.vertices[j];
+                vec2 end = b.vertices[(j + 1) % b.count];
+                for (int i = 0; i < a.count; i++) {
+                    vec2 point = closestPoint(a.vertices[i], start, end);
+                    vec2 difference = point - a.vertices[i];
+                    float distance = glm::dot(difference, difference);
+                    if (distance < best) {best = distance; pointA = a.vertices[i]; pointB = point;}
+                }
+            }
+
+            if (separation > 0.0f) {return true;}
+
+            // Two crossing edges are closest at neither's vertices.
+            if (a.count == 2 && b.count == 2) {
+                vec2 aEdge = a.vertices[1] - a.vertices[0];
+                vec2 bEdge = b.vertices[1] - b.vertices[0];
+                float a0 = cross(aEdge, b.vertices[0] - a.vertices[0]);
+                float a1 = cross(aEdge, b.vertices[1] - a.vertices[0]);
+                float b0 = cross(bEdge, a.vertices[0] - b.vertices[0]);
+                float b1 = cross(bEdge, a.vertices[1] - b.vertices[0]);
+                if (a0 * a1 < 0.0f && b0 * b1 < 0.0f) {return false;}
+            }
+
+            return best > 0.0f;
+
+        }
+
+        // Cuts the segment down to the part behind the plane, returning how many points are left.
+        int clip(vec2* points, vec2 normal, float offset) {
+
+            float d0 = glm::dot(normal, points[0]) - offset;
+            float d1 = glm::dot(normal, points[1]) - offset;
+            if (d0 > 0.0f && d1 > 0.0f) {return 0;}
+            if (d0 > 0.0f) {points[0] = points[0] + (points[1] - points[0]) * (d0 / (d0 - d1));}
+            if (d1 > 0.0f) {points[1] = points[1] + (points[0] - points[1]) * (d1 / (d1 - d0));}
+            return 2;
+
+        }
+
+        // A circle's centre against any other shape, with the normal pointing from the shape to the circle.
+        int findCollisionFeaturesVertex(const RoundedPolygon& shape, vec2 centre, float radius, bool flip, CollisionManifold* result) {
+
+            float total = shape.radius + radius;
+            RoundedPolygon vertex = shape;
+            vertex.vertices[0] = centre;
+            vertex.count = 1;
+            vertex.radius = radius;
+
+            int edge;
+            float separation = findMaxSeparation(shape, vertex, edge);
+            vec2 surface;
+            vec2 normal;
+            float distance;
+
+            vec2 pointA;
+            vec2 pointB;
+            if (findClosestPoints(shape, vertex, separation, pointA, pointB)) {
+
+                vec2 difference = pointB - pointA;
+                distance = glm::length(difference);
+                if (distance > total) {return 0;}
+                normal = difference / distance;
+                surface = pointA;
+
+            } else {
+
+                // The centre is inside the shape, so push it out through the nearest face.
+                normal = shape.count < 2 ? vec2(0.0f, 1.0f) : shape.normals[edge];
+                distance = separation;
+                surface = centre - normal * distance;
+
+            }
+
+            float depth = (total - distance) * 0.5f;
+            vec2 point = surface + normal * (shape.radius - depth);
+            if (flip) {normal = -normal;}
+
+            result[0] = CollisionManifold(normal, point, depth);
+            return 1;
+
+        }
+
+        // Two shapes with at least one edge each. The face that is least deep becomes the reference, and the most
+        // opposed edge of the other shape is clipped against its sides to give up to two contacts.
+        int findCollisionFeaturesPolygons(const RoundedPolygon& a, const RoundedPolygon& b, CollisionManifold* result) {
+
+            float total = a.radius + b.radius;
+
+            int edgeA;
+            int edgeB;
+            float separationA = findMaxSeparation(a, b, edgeA);
+            float separationB = findMaxSeparation(b, a, edgeB);
+            if (separationA > total || separationB > total) {return 0;}
+
+            bool flip = separationB > separationA + REFERENCE_TOLERANCE;
+            const RoundedPolygon& reference = flip ? b : a;
+            const RoundedPolygon& incident = flip ? a : b;
+            int edge = flip ? edgeB : edgeA;
+            float separation = flip ? separationB : separationA;
+
+            vec2 normal = reference.normals[edge];
+            vec2 v1 = reference.vertices[edge];
+            vec2 v2 = reference.vertices[(edge + 1) % reference.count];
+
+            // The incident edge is the one facing most against the reference face.
+            int other = 0;
+            float opposed = FLT_MAX;
+            for (int i = 0; i < incident.count; i++) {
+                float d = glm::dot(normal, incident.normals[i]);
+                if (d < opposed) {opposed = d; other = i;}
+            }
+            vec2 points[2] = {incident.vertices[other], incident.vertices[(other + 1) % incident.count]};
+
+            // When the skins touch but the cores do not, two corners meeting only touch at one point.
+            if (separation > 0.0f) {
+
+                RoundedPolygon face = reference;
+                face.vertices[0] = v1; face.vertices[1] = v2; face.count = 2;
+                RoundedPolygon opposite = incident;
+                opposite.vertices[0] = points[0]; opposite.vertices[1] = points[1]; opposite.count = 2;
+
+                vec2 pointR;
+                vec2 pointI;
+                findClosestPoints(face, opposite, separation, pointR, pointI);
+                bool cornerR = pointR == v1 || pointR == v2;
+                bool cornerI = pointI == points[0] || pointI == points[1];
+
+                if (cornerR && cornerI) {
+
+                    vec2 difference = pointI - pointR;
+                    float distance = glm::length(difference);
+                    if (distance > total) {return 0;}
+                    vec2 direction = difference / distance;
+                    float depth = (total - distance) * 0.5f;
+                    vec2 point = pointR + direction * (reference.radius - depth);
+                    if (flip) {direction = -direction;}
+
+                    result[0] = CollisionManifold(direction, point, depth);
+                    return 1;
+
+                }
+
+            }
+
+            // Keep the part of the incident edge between the sides of the reference face.
+            vec2 tangent = glm::normalize(v2 - v1);
+            if (clip(points, -tangent, -glm::dot(tangent, v1)) < 2) {return 0;}
+            if (clip(points, tangent, glm::dot(tangent, v2)) < 2) {return 0;}
+
+            int count = 0;
+            for (int i = 0; i < 2; i++) {
+
+                float distance = glm::dot(points[i] - v1, normal);
+                if (distance > total) {continue;}
+
+                float depth = (total - distance) * 0.5f;
+                vec2 point = points[i] - normal * (distance - reference.radius + depth);
+                result[count++] = CollisionManifold(flip ? -normal : normal, point, depth);
+
+            }
+
+            return count;
+
+        }
+
+        // Any pair of shapes that includes a polygon or capsule.
+        int findCollisionFeaturesRoundedPolygons(Collider* c1, Collider* c2, CollisionManifold* result) {
+
+            RoundedPolygon a(c1, vec2(0.0f, 0.0f));
+            RoundedPolygon b(c2, vec2(0.0f, 0.0f));
+
+            if (b.count == 1) {return findCollisionFeaturesVertex(a, b.vertices[0], b.radius, false, result);}
+            if (a.count == 1) {return findCollisionFeaturesVertex(b, a.vertices[0], a.radius, true, result);}
+            return findCollisionFeaturesPolygons(a, b, result);
+
+        }
+
+        // Tilemaps can touch more things at once than a single test can report, so they are split into their boxes first.
+        int findCollisionFeaturesTilemapCollider(Collider* c1, Collider* c2, CollisionManifold* result) {
+            return 0;
+        }
+
+        // The collision test for each pair of shapes, indexed by the shape of the first collider then the second.
+        typedef int (*CollisionTest)(Collider* c1, Collider* c2, CollisionManifold* result);
+        const CollisionTest tests[COLLIDER_SHAPES][COLLIDER_SHAPES] = {
+            {findCollisionFeaturesBoxColliderAndBoxCollider, findCollisionFeaturesBoxColliderAndCircleCollider, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesTilemapCollider},
+            {findCollisionFeaturesCircleColliderAndBoxCollider, findCollisionFeaturesCircleColliderAndCircleCollider, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesTilemapCollider},
+            {findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesTilemapCollider},
+            {findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesRoundedPolygons, findCollisionFeaturesTilemapCollider},
+            {findCollisionFeaturesTilemapCollider, findCollisionFeaturesTilemapCollider, findCollisionFeaturesTilemapCollider, findCollisionFeaturesTilemapCollider, findCollisionFeaturesTilemapCollider}
+        };
+
+    }
+
+    namespace {
+
+        // The batched narrowphase is written once against these lane operations, which work on four
+        // pairs at a time with SSE2 and fall back to one pair at a time without it.
+        #if defined(__SSE2__)
+
+        typedef __m128 Lane;
+        typedef __m128 Mask;
+        const int LANES = 4;
+
+        inline Lane load(const float* p) {return _mm_loadu_ps(p);}
+        inline Lane splat(float x) {return _mm_set1_ps(x);}
+        inline Lane add(Lane a, Lane b) {return _mm_add_ps(a, b);}
+        inline Lane sub(Lane a, Lane b) {return _mm_sub_ps(a, b);}
+        inline Lane mul(Lane a, Lane b) {return _mm_mul_ps(a, b);}
+        inline Lane div(Lane a, Lane b) {return _mm_div_ps(a, b);}
+        inline Lane sqrt(Lane a) {return _mm_sqrt_ps(a);}
+        inline Lane abs(Lane a) {return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);}
+        inline Mask lt(Lane a, Lane b) {return _mm_cmplt_ps(a, b);}
+        inline Mask le(Lane a, Lane b) {return _mm_cmple_ps(a, b);}
+        inline Mask gt(Lane a, Lane b) {return _mm_cmpgt_ps(a, b);}
+        inline Mask ge(Lane a, Lane b) {return _mm_cmpge_ps(a, b);}
+        inline Mask ngt(Lane a, Lane b) {return _mm_cmpngt_ps(a, b);}
+        inline Mask neq(Lane a, Lane b) {return _mm_cmpneq_ps(a, b);}
+        inline Mask both(Mask a, Mask b) {return _mm_and_ps(a, b);}
+        inline Mask either(Mask a, Mask b) {return _mm_or_ps(a, b);}
+        inline Lane select(Mask m, Lane a, Lane b) {return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));}
+        inline void store(float* p, Lane a) {_mm_storeu_ps(p, a);}
+        inline int bits(Mask m) {return _mm_movemask_ps(m);}
+
+        #else
+
+        typedef float Lane;
+        typedef bool Mask;
+        const int LANES = 1;
+
+        inline Lane load(const float* p) {return *p;}
+        inline Lane splat(float x) {return x;}
+        inline Lane add(Lane a, Lane b) {return a + b;}
+        inline Lane sub(Lane a, Lane b) {return a - b;}
+        inline Lane mul(Lane a, Lane b) {return a * b;}
+        inline Lane div(Lane a, Lane b) {return a / b;}
+        inline Lane sqrt(Lane a) {return sqrtf(a);}
+        inline Lane abs(Lane a) {return fabsf(a);}
+        inline Mask lt(Lane a, Lane b) {return a < b;}
+        inline Mask le(Lane a, Lane b) {return a <= b;}
+        inline Mask gt(Lane a, Lane b) {return a > b;}
+        inline Mask ge(Lane a, Lane b) {return a >= b;}
+        inline Mask ngt(Lane a, Lane b) {return !(a > b);}
+        inline Mask neq(Lane a, Lane b) {return a != b;}
+        inline Mask both(Mask a, Mask b) {return a && b;}
+        inline Mask either(Mask a, Mask b) {return a || b;}
+        inline Lane select(Mask m, Lane a, Lane b) {return m ? a : b;}
+        inline void store(float* p, Lane a) {*p = a;}
+        inline int bits(Mask m) {return m ? 1 : 0;}
+
+        #endif
+
+        // Reads a block of lanes starting at i, padding past the end of the array with zeros.
+        inline Lane load(const std::vector<float>& v, int i, int count) {
+            if (count == LANES) {return load(v.data() + i);}
+            float padded[LANES] = {};
+            for (int k = 0; k < count; k++) {padded[k] = v[i + k];}
+            return load(padded);
+        }
+
+        // Writes the first count lanes of a block out as manifolds.
+        inline void store(CollisionManifold* manifolds, unsigned char* hits, int count, Mask hit, Lane nx, Lane ny, Lane px, Lane py, Lane depth) {
+
+            float normalX[LANES], normalY[LANES], pointX[LANES], pointY[LANES], depths[LANES];
+            store(normalX, nx);
+            store(normalY, ny);
+            store(pointX, px);
+            store(pointY, py);
+            store(depths, depth);
+
+            int mask = bits(hit);
+            for (int k = 0; k < count; k++) {
+                hits[k] = (mask >> k) & 1;
+                if (hits[k]) {manifolds[k] = CollisionManifold(vec2(normalX[k], normalY[k]), vec2(pointX[k], pointY[k]), depths[k]);}
+            }
+
+        }
+
+    }
+
+    RoundedPolygon::RoundedPolygon(Collider* collider, vec2 offset) {
+
+        vec2 local[MAX_POLYGON_VERTICES];
+        this->count = 0;
+        this->radius = 0.0f;
+
+        switch (collider->getShape()) {
+
+            case BOX_COLLIDER: {
+                vec2 half = ((BoxCollider*) collider)->getSize() * 0.5f;
+                local[0] = vec2(-half.x, -half.y);
+                local[1] = vec2( half.x, -half.y);
+                local[2] = vec2( half.x,  half.y);
+                local[3] = vec2(-half.x,  half.y);
+                this->count = 4;
+                break;
+            }
+
+            case CIRCLE_COLLIDER: {
+                local[0] = vec2(0.0f, 0.0f);
+                this->count = 1;
+                this->radius = ((CircleCollider*) collider)->getRadius();
+                break;
+            }
+
+            case POLYGON_COLLIDER: {
+                std::vector<vec2> vertices = ((PolygonCollider*) collider)->getVertices();
+                for (vec2 v : vertices) {local[this->count++] = v;}
+                break;
+            }
+
+            case CAPSULE_COLLIDER: {
+                CapsuleCollider* capsule = (CapsuleCollider*) collider;
+                local[0] = vec2(-capsule->getLength() * 0.5f, 0.0f);
+                local[1] = vec2( capsule->getLength() * 0.5f, 0.0f);
+                this->count = capsule->getLength() > 0.0f ? 2 : 1;
+                this->radius = capsule->getRadius();
+                break;
+            }
+
+            default: break;
+
+        }
+
+        // Move the outline into world space.
+        vec2 position = collider->getPosition() + offset;
+        float rotation = collider->getRotation();
+        float rCos = cosf(rotation);
+        float rSin = sinf(rotation);
+        for (int i = 0; i < this->count; i++) {
+            this->vertices[i] = local[i];
+            rotate(this->vertices[i], vec2(0.0f, 0.0f), rCos, rSin);
+            this->vertices[i] += position;
+        }
+
+        if (this->count < 2) {return;}
+        for (int i = 0; i < this->count; i++) {
+            vec2 edge = this->vertices[(i + 1) % this->count] - this->vertices[i];
+            this->normals[i] = glm::normalize(vec2(edge.y, -edge.x));
+        }
+
+    }
+
+    RoundedPolygon::RoundedPolygon(vec2 centre, float radius) {
+        this->vertices[0] = centre;
+        this->count = 1;
+        this->radius = radius;
+    }
+
+    RoundedPolygon::RoundedPolygon(vec2 centre, vec2 size, float rotation) {
+
+        vec2 half = size * 0.5f;
+        this->vertices[0] = vec2(-half.x, -half.y);
+        this->vertices[1] = vec2( half.x, -half.y);
+        this->vertices[2] = vec2( half.x,  half.y);
+        this->vertices[3] = vec2(-half.x,  half.y);
+        this->normals[0] = vec2( 0.0f, -1.0f);
+        this->normals[1] = vec2( 1.0f,  0.0f);
+        this->normals[2] = vec2( 0.0f,  1.0f);
+        this->normals[3] = vec2(-1.0f,  0.0f);
+        this->count = 4;
+        this->radius = 0.0f;
+
+        float rCos = cosf(rotation);
+        float rSin = sinf(rotation);
+        for (int i = 0; i < 4; i++) {
+            rotate(this->vertices[i], vec2(0.0f, 0.0f), rCos, rSin);
+            rotate(this->normals[i], vec2(0.0f, 0.0f), rCos, rSin);
+            this->vertices[i] += centre;
+        }
+
+    }
+
+    RoundedPolygon RoundedPolygon::translate(vec2 offset) const {
+        RoundedPolygon moved = *this;
+        for (int i = 0; i < moved.count; i++) {moved.vertices[i] += offset;}
+        return moved;
+    }
+
+    int CirclePairs::size() {
+        return this->aX.size();
+    }
+
+    void CirclePairs::clear() {
+        this->aX.clear();
+        this->aY.clear();
+        this->aRadius.clear();
+        this->bX.clear();
+        this->bY.clear();
+        this->bRadius.clear();
+    }
+
+    void CirclePairs::add(CircleCollider* a, CircleCollider* b) {
+        vec2 aPosition = a->getPosition();
+        vec2 bPosition = b->getPosition();
+        this->aX.push_back(aPosition.x);
+        this->aY.push_back(aPosition.y);
+        this->aRadius.push_back(a->getRadius());
+        this->bX.push_back(bPosition.x);
+        this->bY.push_back(bPosition.y);
+        this->bRadius.push_back(b->getRadius());
+    }
+
+    int CircleBoxPairs::size() {
+        return this->circleX.size();
+    }
+
+    void CircleBoxPairs::clear() {
+        this->circleX.clear();
+        this->circleY.clear();
+        this->radius.clear();
+        this->boxX.clear();
+        this->boxY.clear();
+        this->halfWidth.clear();
+        this->halfHeight.clear();
+        this->cos.clear();
+        this->sin.clear();
+        this->sign.clear();
+    }
+
+    void CircleBoxPairs::add(CircleCollider* c, BoxCollider* b, bool flip) {
+
+        vec2 cPos = c->getPosition();
+        vec2 bPos = b->getPosition();
+        vec2 bHalf = b->getSize() * 0.5f;
+        float bRot = b->getRotation();
+
+        this->circleX.push_back(cPos.x);
+        this->circleY.push_back(cPos.y);
+        this->radius.push_back(c->getRadius());
+        this->boxX.push_back(bPos.x);
+        this->boxY.push_back(bPos.y);
+        this->halfWidth.push_back(bHalf.x);
+        this->halfHeight.push_back(bHalf.y);
+        this->cos.push_back(bRot != 0.0f ? cosf(-bRot) : 1.0f);
+        this->sin.push_back(bRot != 0.0f ? sinf(-bRot) : 0.0f);
+        this->sign.push_back(flip ? -1.0f : 1.0f);
+
     }
 
     namespace Collision {
         
         std::vector<CollisionManifold> findCollisionFeatures(Collider* c1, Collider* c2) {
+            CollisionManifold result[MAX_MANIFOLDS];
+            int count = findCollisionFeatures(c1, c2, result);
+            return std::vector<CollisionManifold>(result, result + count);
+        }
 
-            if (dynamic_cast<BoxCollider*>(c1) != nullptr && dynamic_cast<BoxCollider*>(c2) != nullptr) {return findCollisionFeaturesBoxColliderAndBoxCollider((BoxCollider*) c1, (BoxCollider*) c2);}
-            if (dynamic_cast<CircleCollider*>(c1) != nullptr && dynamic_cast<CircleCollider*>(c2) != nullptr) {return findCollisionFeaturesCircleColliderAndCircleCollider((CircleCollider*) c1, (CircleCollider*) c2);}
-            if (dynamic_cast<CircleCollider*>(c1) != nullptr && dynamic_cast<BoxCollider*>(c2) != nullptr) {return findCollisionFeaturesCircleColliderAndBoxCollider((CircleCollider*) c1, (BoxCollider*) c2, false);}
-            if (dynamic_cast<BoxCollider*>(c1) != nullptr && dynamic_cast<CircleCollider*>(c2) != nullptr) {return findCollisionFeaturesCircleColliderAndBoxCollider((CircleCollider*) c2, (BoxCollider*) c1, true);}
+        int findCollisionFeatures(Collider* c1, Collider* c2, CollisionManifold* result) {
+            return tests[c1->getShape()][c2->getShape()](c1, c2, result);
+        }
+
+        float findDistance(Collider* c1, vec2 offset, Collider* c2, vec2& normal) {
+            return findDistance(RoundedPolygon(c1, offset), RoundedPolygon(c2, vec2(0.0f, 0.0f)), normal);
+        }
+
+        float findDistance(const RoundedPolygon& a, const RoundedPolygon& b, vec2& normal) {
+
+            float total = a.radius + b.radius;
+
+            int edgeA;
+            int edgeB;
+            float separationA = findMaxSeparation(a, b, edgeA);
+            float separationB = findMaxSeparation(b, a, edgeB);
+            float separation = std::max(separationA, separationB);
+
+            vec2 pointA;
+            vec2 pointB;
+            if (findClosestPoints(a, b, separation, pointA, pointB)) {
+                vec2 difference = pointB - pointA;
+                float distance = glm::length(difference);
+                normal = difference / distance;
+                return distance - total;
+            }
+
+            if (a.count < 2 && b.count < 2) {normal = vec2(0.0f, 1.0f); return -total;}
+            normal = separationA >= separationB ? a.normals[edgeA] : -b.normals[edgeB];
+            return separation - total;
 
-            std::vector<CollisionManifold> empty;
-            return empty;
+        }
+
+        void findCollisionFeatures(CirclePairs& pairs, CollisionManifold* manifolds, unsigned char* hits) {
+
+            // The same steps as findCollisionFeaturesCircleColliderAndCircleCollider, for a block of pairs at a time.
+            int n = pairs.size();
+            for (int i = 0; i < n; i += LANES) {
+
+                int count = std::min(LANES, n - i);
+                Lane aX = load(pairs.aX, i, count);
+                Lane aY = load(pairs.aY, i, count);
+                Lane aRadius = load(pairs.aRadius, i, count);
+                Lane bX = load(pairs.bX, i, count);
+                Lane bY = load(pairs.bY, i, count);
+                Lane bRadius = load(pairs.bRadius, i, count);
+
+                // Determine if the two circles are colliding.
+                Lane sumRadii = add(aRadius, bRadius);
+                Lane dx = sub(bX, aX);
+                Lane dy = sub(bY, aY);
+                Lane lengthSquared = add(mul(dx, dx), mul(dy, dy));
+                Mask hit = ngt(sub(lengthSquared, mul(sumRadii, sumRadii)), splat(0.0f));
+
+                // Find the depth and normal of the collision.
+                Lane length = sqrt(lengthSquared);
+                Lane depth = mul(abs(sub(length, sumRadii)), splat(0.5f));
+                Lane inverse = div(splat(1.0f), length);
+                Lane nx = mul(dx, inverse);
+                Lane ny = mul(dy, inverse);
+
+                // Find the contact point of the collision.
+                Lane distanceToPoint = sub(aRadius, depth);
+                Lane px = add(mul(distanceToPoint, nx), aX);
+                Lane py = add(mul(distanceToPoint, ny), aY);
+
+                store(manifolds + i, hits + i, count, hit, nx, ny, px, py, depth);
+
+            }
+
+        }
+
+        void findCollisionFeatures(CircleBoxPairs& pairs, CollisionManifold* manifolds, unsigned char* hits) {
+
+            // The same cases as findCollisionFeaturesCircleColliderAndBoxCollider, for a block of pairs at a
+            // time. Every case is evaluated and the first that applies is kept.
+            int n = pairs.size();
+            for (int i = 0; i < n; i += LANES) {
+
+                int count = std::min(LANES, n - i);
+                Lane cX = load(pairs.circleX, i, count);
+                Lane cY = load(pairs.circleY, i, count);
+                Lane radius = load(pairs.radius, i, count);
+                Lane bX = load(pairs.boxX, i, count);
+                Lane bY = load(pairs.boxY, i, count);
+                Lane halfWidth = load(pairs.halfWidth, i, count);
+                Lane halfHeight = load(pairs.halfHeight, i, count);
+                Lane rCos = load(pairs.cos, i, count);
+                Lane rSin = load(pairs.sin, i, count);
+                Lane sign = load(pairs.sign, i, count);
+
+                // Rotate the circle into the box's space.
+                Mask rotated = either(neq(rCos, splat(1.0f)), neq(rSin, splat(0.0f)));
+                Lane x = sub(cX, bX);
+                Lane y = sub(cY, bY);
+                cX = select(rotated, add(bX, sub(mul(x, rCos), mul(y, rSin))), cX);
+                cY = select(rotated, add(bY, add(mul(x, rSin), mul(y, rCos))), cY);
+
+                Lane minX = sub(bX, halfWidth);
+                Lane minY = sub(bY, halfHeight);
+                Lane maxX = add(bX, halfWidth);
+                Lane maxY = add(bY, halfHeight);
+                Lane radiusSquared = mul(radius, radius);
+                Mask insideX = both(ge(cX, minX), le(cX, maxX));
+                Mask insideY = both(ge(cY, minY), le(cY, maxY));
+
+                // The faces of the box.
+                Mask top = both(insideX, both(ge(cY, maxY), lt(cY, add(maxY, radius))));
+                Mask bottom = both(insideX, both(gt(cY, sub(minY, radius)), le(cY, minY)));
+                Mask right = both(insideY, both(ge(cX, maxX), lt(cX, add(maxX, radius))));
+                Mask left = both(insideY, both(gt(cX, sub(minX, radius)), le(cX, minX)));
+
+                // The corners of the box, top left first.
+                Lane leftX = sub(cX, minX);
+                Lane rightX = sub(cX, maxX);
+                Lane topY = sub(cY, maxY);
+                Lane bottomY = sub(cY, minY);
+                Mask topLeft = lt(add(mul(leftX, leftX), mul(topY, topY)), radiusSquared);
+                Mask topRight = lt(add(mul(rightX, rightX), mul(topY, topY)), radiusSquared);
+                Mask bottomLeft = lt(add(mul(leftX, leftX), mul(bottomY, bottomY)), radiusSquared);
+                Mask bottomRight = lt(add(mul(rightX, rightX), mul(bottomY, bottomY)), radiusSquared);
+
+                Lane cornerX = maxX;
+                Lane cornerY = minY;
+                cornerX = select(bottomLeft, minX, cornerX);
+                cornerX = select(topRight, maxX, cornerX); cornerY = select(topRight, maxY, cornerY);
+                cornerX = select(topLeft, minX, cornerX); cornerY = select(topLeft, maxY, cornerY);
+
+                Lane dx = sub(cornerX, cX);
+                Lane dy = sub(cornerY, cY);
+                Lane inverse = div(splat(1.0f), sqrt(add(mul(dx, dx), mul(dy, dy))));
+                Lane nx = mul(dx, inverse);
+                Lane ny = mul(dy, inverse);
+                Lane depthX = mul(sub(mul(nx, radius), dx), splat(0.5f));
+                Lane depthY = mul(sub(mul(ny, radius), dy), splat(0.5f));
+                Lane depth = sqrt(add(mul(depthX, depthX), mul(depthY, depthY)));
+                Lane px = add(cornerX, depthX);
+                Lane py = add(cornerY, depthY);
+
+                // Faces take priority over corners, in the same order as the single pair test.
+                Lane faceDepth = mul(sub(add(cX, radius), minX), splat(0.5f));
+                depth = select(left, faceDepth, depth); nx = select(left, splat(1.0f), nx); ny = select(left, splat(0.0f), ny);
+                px = select(left, add(minX, faceDepth), px); py = select(left, cY, py);
+
+                faceDepth = mul(sub(maxX, sub(cX, radius)), splat(0.5f));
+                depth = select(right, faceDepth, depth); nx = select(right, splat(-1.0f), nx); ny = select(right, splat(0.0f), ny);
+                px = select(right, sub(maxX, faceDepth), px); py = select(right, cY, py);
+
+                faceDepth = mul(sub(add(cY, radius), minY), splat(0.5f));
+                depth = select(bottom, faceDepth, depth); nx = select(bottom, splat(0.0f), nx); ny = select(bottom, splat(1.0f), ny);
+                px = select(bottom, cX, px); py = select(bottom, add(minY, faceDepth), py);
+
+                faceDepth = mul(sub(maxY, sub(cY, radius)), splat(0.5f));
+                depth = select(top, faceDepth, depth); nx = select(top, splat(0.0f), nx); ny = select(top, splat(-1.0f), ny);
+                px = select(top, cX, px); py = select(top, sub(maxY, faceDepth), py);
+
+                Mask hit = either(either(either(top, bottom), either(right, left)), either(either(topLeft, topRight), either(bottomLeft, bottomRight)));
+
+                // Rotate back into global space, and point the normal away from whichever collider came first.
+                Lane rx = add(mul(nx, rCos), mul(ny, rSin));
+                Lane ry = sub(mul(ny, rCos), mul(nx, rSin));
+                nx = mul(select(rotated, rx, nx), sign);
+                ny = mul(select(rotated, ry, ny), sign);
+
+                x = sub(px, bX);
+                y = sub(py, bY);
+                px = select(rotated, add(bX, add(mul(x, rCos), mul(y, rSin))), px);
+                py = select(rotated, add(bY, sub(mul(y, rCos), mul(x, rSin))), py);
+
+                store(manifolds + i, hits + i, count, hit, nx, ny, px, py, depth);
+
+            }
 
         }
 
@@ -0,0 +1,192 @@
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/geometric.hpp>
+#include "pancake/physics/continuous.hpp"
+
+namespace Pancake {
+
+    namespace {
+
+        // Colliders are advanced until they are this far apart, so they do not start the next step overlapping.
+        const float TARGET_SEPARATION = 0.01f;
+
+        // How close to the target separation counts as an impact.
+        const float TOLERANCE = 0.0025f;
+
+        const int MAX_ITERATIONS = 20;
+
+        inline vec2 rotate(vec2 v, float rCos, float rSin) {
+            return vec2(v.x * rCos - v.y * rSin, v.x * rSin + v.y * rCos);
+        }
+
+        float distanceCircleAndCircle(vec2 a, float aRadius, vec2 b, float bRadius, vec2& normal) {
+            vec2 difference = b - a;
+            float length = glm::length(difference);
+            normal = length > 0.0f ? difference / length : vec2(0.0f, 1.0f);
+            return length - aRadius - bRadius;
+        }
+
+        float distanceCircleAndBox(vec2 c, float radius, vec2 bPos, vec2 bHalf, float bRot, vec2& normal) {
+
+            // Take the circle into the box's space, and find its distance from the nearest face or corner.
+            float rCos = cosf(bRot);
+            float rSin = sinf(bRot);
+            vec2 local = rotate(c - bPos, rCos, -rSin);
+            vec2 q = vec2(fabsf(local.x), fabsf(local.y)) - bHalf;
+            vec2 sign = vec2(local.x < 0.0f ? -1.0f : 1.0f, local.y < 0.0f ? -1.0f : 1.0f);
+
+            float distance;
+            vec2 outward;
+            if (q.x > 0.0f || q.y > 0.0f) {
+                vec2 outside = vec2(std::max(q.x, 0.0f), std::max(q.y, 0.0f));
+                distance = glm::length(outside);
+                outward = outside / distance * sign;
+            } else if (q.x > q.y) {
+                distance = q.x;
+                outward = vec2(sign.x, 0.0f);
+            } else {
+                distance = q.y;
+                outward = vec2(0.0f, sign.y);
+            }
+
+            // The normal points from the circle towards the box.
+            normal = -rotate(outward, rCos, rSin);
+            return distance - radius;
+
+        }
+
+        float distanceBoxAndBox(vec2 aPos, vec2 aHalf, float aRot, vec2 bPos, vec2 bHalf, float bRot, vec2& normal) {
+
+            // The largest gap along the face normals of either box. It is never more than the true
+            // distance, so advancing by it cannot step past an impact.
+            vec2 aAxes[2] = {vec2(cosf(aRot), sinf(aRot)), vec2(-sinf(aRot), cosf(aRot))};
+            vec2 bAxes[2] = {vec2(cosf(bRot), sinf(bRot)), vec2(-sinf(bRot), cosf(bRot))};
+            vec2 axes[4] = {aAxes[0], aAxes[1], bAxes[0], bAxes[1]};
+
+            float best = -FLT_MAX;
+            for (vec2 axis : axes) {
+
+                float aCenter = glm::dot(aPos, axis);
+                float bCenter = glm::dot(bPos, axis);
+                float aExtent = aHalf.x * fabsf(glm::dot(aAxes[0], axis)) + aHalf.y * fabsf(glm::dot(aAxes[1], axis));
+                float bExtent = bHalf.x * fabsf(glm::dot(bAxes[0], axis)) + bHalf.y * fabsf(glm::dot(bAxes[1], axis));
+
+                float ahead = (bCenter - bExtent) - (aCenter + aExtent);
+                float behind = (aCenter - aExtent) - (bCenter + bExtent);
+                if (ahead > best) {best = ahead; normal = axis;}
+                if (behind > best) {best = behind; normal = -axis;}
+
+            }
+
+            return best;
+
+        }
+
+        float distanceBoxColliderAndBoxCollider(Collider* c1, vec2 offset, Collider* c2, vec2& normal) {
+            BoxCollider* a = (BoxCollider*) c1;
+            BoxCollider* b = (BoxCollider*) c2;
+            return distanceBoxAndBox(a->getPosition() + offset, a->getSize() * 0.5f, a->getRotation(), b->getPosition(), b->getSize() * 0.5f, b->getRotation(), normal);
+        }
+
+        float distanceBoxColliderAndCircleCollider(Collider* c1, vec2 offset, Collider* c2, vec2& normal) {
+            BoxCollider* a = (BoxCollider*) c1;
+            CircleCollider* b = (CircleCollider*) c2;
+            float distance = distanceCircleAndBox(b->getPosition() - offset, b->getRadius(), a->getPosition(), a->getSize() * 0.5f, a->getRotation(), normal);
+            normal = -normal;
+            return distance;
+        }
+
+        float distanceCircleColliderAndBoxCollider(Collider* c1, vec2 offset, Collider* c2, vec2& normal) {
+            CircleCollider* a = (CircleCollider*) c1;
+            BoxCollider* b = (BoxCollider*) c2;
+            return distanceCircleAndBox(a->getPosition() + offset, a->getRadius(), b->getPosition(), b->getSize() * 0.5f, b->getRotation(), normal);
+        }
+
+        float distanceCircleColliderAndCircleCollider(Collider* c1, vec2 offset, Collider* c2, vec2& normal) {
+            CircleCollider* a = (CircleCollider*) c1;
+            CircleCollider* b = (CircleCollider*) c2;
+            return distanceCircleAndCircle(a->getPosition() + offset, a->getRadius(), b->getPosition(), b->getRadius(), normal);
+        }
+
+        // Tilemaps are swept against box by box, so are never hit as a whole.
+        float distanceTilemapCollider(Collider* c1, vec2 offset, Collider* c2, vec2& normal) {
+            return FLT_MAX;
+        }
+
+        // The distance test for each pair of shapes, indexed by the shape of the moving collider then the other.
+        // Pairs with a polygon or capsule use the general distance between rounded polygons.
+        typedef float (*DistanceTest)(Collider* c1, vec2 offset, Collider* c2, vec2& normal);
+        const DistanceTest tests[COLLIDER_SHAPES][COLLIDER_SHAPES] = {
+            {distanceBoxColliderAndBoxCollider, distanceBoxColliderAndCircleCollider, Collision::findDistance, Collision::findDistance, distanceTilemapCollider},
+            {distanceCircleColliderAndBoxCollider, distanceCircleColliderAndCircleCollider, Collision::findDistance, Collision::findDistance, distanceTilemapCollider},
+            {Collision::findDistance, Collision::findDistance, Collision::findDistance, Collision::findDistance, distanceTilemapCollider},
+            {Collision::findDistance, Collision::findDistance, Collision::findDistance, Collision::findDistance, distanceTilemapCollider},
+            {distanceTilemapCollider, distanceTilemapCollider, distanceTilemapCollider, distanceTilemapCollider, distanceTilemapCollider}
+        };
+
+        // Conservative advancement: nothing can close the gap faster than the collider moves, so it can
+        // always be moved by the current distance without passing through the other collider.
+        // Colliders that start touching are an impact at the start if they are closing, which is where the
+        // last impact leaves them, or always when overlaps are reported.
+        template<class F>
+        TimeOfImpact advance(vec2 displacement, bool overlaps, F distance) {
+
+            float length = glm::length(displacement);
+            float t = 0.0f;
+            vec2 normal;
+            for (int i = 0; i < MAX_ITERATIONS; i++) {
+
+                float gap = distance(t, normal);
+
+                if (gap < TARGET_SEPARATION + TOLERANCE) {
+                    if (i == 0 && !overlaps && glm::dot(displacement, normal) <= 0.0f) {return TimeOfImpact();}
+                    return TimeOfImpact(t, normal);
+                }
+
+                if (length <= 0.0f) {return TimeOfImpact();}
+                t += (gap - TARGET_SEPARATION) / length;
+                if (t >= 1.0f) {return TimeOfImpact();}
+
+            }
+
+            // Still closing in slowly, so stop where the search got to rather than let it pass.
+            return TimeOfImpact(t, normal);
+
+        }
+
+    }
+
+    TimeOfImpact::TimeOfImpact() {
+        this->hit = false;
+        this->time = 1.0f;
+        this->normal = vec2(0.0f, 0.0f);
+    }
+
+    TimeOfImpact::TimeOfImpact(float time, vec2 normal) {
+        this->hit = true;
+        this->time = time;
+        this->normal = normal;
+    }
+
+    namespace Continuous {
+
+        TimeOfImpact findTimeOfImpact(Collider* c1, vec2 displacement, Collider* c2) {
+            DistanceTest test = tests[c1->getShape()][c2->getShape()];
+            return advance(displacement, false, [&](float t, vec2& normal) {
+                return test(c1, displacement * t, c2, normal);
+            });
+        }
+
+        TimeOfImpact findTimeOfImpact(const RoundedPolygon& shape, vec2 displacement, Collider* c2) {
+            if (c2->getShape() == TILEMAP_COLLIDER) {return TimeOfImpact();}
+            RoundedPolygon other(c2, vec2(0.0f, 0.0f));
+            return advance(displacement, true, [&](float t, vec2& normal) {
+                return Collision::findDistance(shape.translate(displacement * t), other, normal);
+            });
+        }
+
+    }
+
+}
@@ -62,6 +62,7 @@ namespace Pancake {
         int n = this->registry.size();
         for (int i = 0; i < n; i++) {
             ForceRegistration registration = this->registry[i];
+            if (!registration.rigidbody->isAwake()) {continue;}
             registration.generator->updateForce(registration.rigidbody, dt);
         }
     }
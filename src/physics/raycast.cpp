@@ -3,6 +3,7 @@
 #include <algorithm>
 #include "pancake/physics/raycast.hpp"
 #include "pancake/physics/collider.hpp"
+#include "pancake/physics/collision.hpp"
 
 namespace Pancake {
 
@@ -20,6 +21,15 @@ namespace Pancake {
     Ray::Ray(vec2 origin, vec2 direction) {
         this->origin = origin;
         this->direction = glm::normalize(direction);
+        this->distance = FLT_MAX;
+        this->mask = ALL_LAYERS;
+    }
+
+    Ray::Ray(vec2 origin, vec2 direction, float distance) {
+        this->origin = origin;
+        this->direction = glm::normalize(direction);
+        this->distance = distance;
+        this->mask = ALL_LAYERS;
     }
 
     void Ray::rotate(vec2 around, float rCos, float rSin) {
@@ -41,8 +51,73 @@ namespace Pancake {
         this->hit = nullptr;
     }
 
+    void RaycastHits::clear() {
+        this->hits.clear();
+        this->starts.clear();
+        this->starts.push_back(0);
+    }
+
+    int RaycastHits::size() {
+        return std::max((int) this->starts.size() - 1, 0);
+    }
+
+    int RaycastHits::count(int query) {
+        return this->starts[query + 1] - this->starts[query];
+    }
+
+    RaycastResult RaycastHits::get(int query, int hit) {
+        return this->hits[this->starts[query] + hit];
+    }
+
     namespace {
 
+        // Where a ray enters a box centred on the origin, and the normal of the face it enters through. Rays
+        // that start inside the box do not hit it.
+        bool raycastBox(vec2 origin, vec2 direction, vec2 half, float& t, vec2& normal) {
+
+            float enter = -FLT_MAX;
+            float exit = FLT_MAX;
+            for (int i = 0; i < 2; i++) {
+
+                if (direction[i] == 0.0f) {
+                    if (fabsf(origin[i]) > half[i]) {return false;}
+                    continue;
+                }
+
+                float t0 = (-half[i] - origin[i]) / direction[i];
+                float t1 = (half[i] - origin[i]) / direction[i];
+                vec2 face = vec2(0.0f, 0.0f);
+                face[i] = -1.0f;
+                if (t0 > t1) {std::swap(t0, t1); face[i] = 1.0f;}
+                if (t0 > enter) {enter = t0; normal = face;}
+                exit = std::min(exit, t1);
+
+            }
+
+            if (enter > exit || enter < 0.0f) {return false;}
+            t = enter;
+            return true;
+
+        }
+
+        // Where a ray enters a circle. Rays that start inside the circle do not hit it.
+        bool raycastCircle(vec2 origin, vec2 direction, vec2 centre, float radius, float& t) {
+
+            vec2 originToCentre = centre - origin;
+            float radiusSquared = radius * radius;
+            float lengthSquared = glm::dot(originToCentre, originToCentre);
+            if (lengthSquared < radiusSquared) {return false;}
+
+            // Project the vector from the ray origin onto the direction of the ray.
+            float a = glm::dot(originToCentre, direction);
+            float b2 = lengthSquared - (a * a);
+            if (radiusSquared - b2 < 0.0f) {return false;}
+
+            t = a - sqrtf(radiusSquared - b2);
+            return t >= 0.0f;
+
+        }
+
         RaycastResult raycastBoxCollider(BoxCollider* box, Ray ray) {
 
             // Rotate the ray into the box's local space.
@@ -50,54 +125,146 @@ namespace Pancake {
             float radians = box->getRotation();
             float rCos = cosf(radians);
             float rSin = sinf(radians);
-            ray.rotate(centre, rCos, rSin);
+            ray.rotate(centre, rCos, -rSin);
 
-            // Perform the ray cast in local space.
-            vec2 unitVector = glm::normalize(ray.direction);
-            vec2 min = box->getPosition() - box->getSize() * 0.5f;
-            vec2 max = box->getPosition() + box->getSize() * 0.5f;
+            float t;
+            vec2 normal;
+            if (!raycastBox(ray.origin - centre, ray.direction, box->getSize() * 0.5f, t, normal)) {return RaycastResult();}
 
-            float tMin = std::max(std::min(min.x, max.x), std::min(min.y, max.y));
-            float tMax = std::min(std::max(min.x, max.x), std::max(min.y, max.y));
+            // Rotate the result back into global space.
+            vec2 point = ray.direction * t + ray.origin;
+            rotateVector(point, centre, rCos, rSin);
+            rotateVector(normal, vec2(0.0f, 0.0f), rCos, rSin);
 
-            if (tMax < 0 || tMin > tMax) {return RaycastResult();}
+            return RaycastResult(point, normal, t, box->getRigidbody()->getEntity());
+
+        }
+
+        RaycastResult raycastCircleCollider(CircleCollider* circle, Ray ray) {
 
-            float t = (tMin < 0.0f) ? tMax : tMin;
-            bool hit = t > 0.0f;
-            if (!hit) {return RaycastResult();}
+            vec2 centre = circle->getPosition();
+            float t;
+            if (!raycastCircle(ray.origin, ray.direction, centre, circle->getRadius(), t)) {return RaycastResult();}
 
-            // Get the point and normal in the box's local space.
             vec2 point = ray.direction * t + ray.origin;
-            vec2 normal = glm::normalize(ray.origin - point);
+            vec2 normal = glm::normalize(point - centre);
+            return RaycastResult(point, normal, t, circle->getRigidbody()->getEntity());
 
-            // Rotate the result back into global space.
-            rotateVector(point, centre, rCos, -rSin);
-            rotateVector(normal, vec2(0.0f, 0.0f), rCos, -rSin);
+        }
 
-            return RaycastResult(point, normal, t, box->getRigidbody()->getEntity());
+        RaycastResult raycastPolygonCollider(PolygonCollider* polygon, Ray ray) {
+
+            // Clip the ray against each face in turn, keeping the last face it enters through.
+            RoundedPolygon shape(polygon, vec2(0.0f, 0.0f));
+            float lower = 0.0f;
+            float upper = FLT_MAX;
+            int face = -1;
+
+            for (int i = 0; i < shape.count; i++) {
+
+                float numerator = glm::dot(shape.normals[i], shape.vertices[i] - ray.origin);
+                float denominator = glm::dot(shape.normals[i], ray.direction);
+
+                if (denominator == 0.0f) {
+                    if (numerator < 0.0f) {return RaycastResult();}
+                    continue;
+                }
+
+                if (denominator < 0.0f && numerator < lower * denominator) {lower = numerator / denominator; face = i;}
+                else if (denominator > 0.0f && numerator < upper * denominator) {upper = numerator / denominator;}
+                if (upper < lower) {return RaycastResult();}
+
+            }
+
+            // A ray that starts inside never crosses a face on the way in.
+            if (face == -1) {return RaycastResult();}
+
+            vec2 point = ray.direction * lower + ray.origin;
+            return RaycastResult(point, shape.normals[face], lower, polygon->getRigidbody()->getEntity());
 
         }
 
-        RaycastResult raycastCircleCollider(CircleCollider* circle, Ray ray) {
+        RaycastResult raycastCapsuleCollider(CapsuleCollider* capsule, Ray ray) {
 
-            vec2 position = circle->getPosition();
-            vec2 originToCircleCollider = position - ray.origin;
-            float radiusSquared = circle->getRadius() * circle->getRadius();
-            float originToCircleColliderLengthSquared = glm::dot(originToCircleCollider, originToCircleCollider);
+            // Rotate the ray into the capsule's local space, where it lies along the x axis.
+            vec2 centre = capsule->getPosition();
+            float radians = capsule->getRotation();
+            float rCos = cosf(radians);
+            float rSin = sinf(radians);
+            ray.rotate(centre, rCos, -rSin);
+            vec2 origin = ray.origin - centre;
+
+            float half = capsule->getLength() * 0.5f;
+            float radius = capsule->getRadius();
+            vec2 nearest = vec2(std::min(std::max(origin.x, -half), half), 0.0f);
+            if (glm::dot(origin - nearest, origin - nearest) < radius * radius) {return RaycastResult();}
+
+            // The ray enters through one of the flat sides, or one of the rounded ends.
+            float best = FLT_MAX;
+            vec2 normal;
+            float t;
+            vec2 face;
+            if (raycastBox(origin, ray.direction, vec2(half, radius), t, face) && face.y != 0.0f) {best = t; normal = face;}
+            for (float end : {-half, half}) {
+                if (!raycastCircle(origin, ray.direction, vec2(end, 0.0f), radius, t) || t >= best) {continue;}
+                best = t;
+                normal = glm::normalize(origin + ray.direction * t - vec2(end, 0.0f));
+            }
+            if (best == FLT_MAX) {return RaycastResult();}
 
-            // Project the vector from the ray origin onto the direction of the ray.
-            float a = glm::dot(originToCircleCollider, ray.direction);
-            float b2 = originToCircleColliderLengthSquared - (a * a);
-            if (radiusSquared - b2 < 0.0f) {return RaycastResult();}
+            // Rotate the result back into global space.
+            vec2 point = ray.direction * best + ray.origin;
+            rotateVector(point, centre, rCos, rSin);
+            rotateVector(normal, vec2(0.0f, 0.0f), rCos, rSin);
 
-            float f = sqrtf(radiusSquared - b2);
-            float t = 0;
-            if (originToCircleColliderLengthSquared < radiusSquared) {t = a + f;}
-            else {t = a - f;}
+            return RaycastResult(point, normal, best, capsule->getRigidbody()->getEntity());
 
-            vec2 point = ray.direction * t + ray.origin;
-            vec2 normal = glm::normalize(ray.origin - point);
-            return RaycastResult(point, normal, t, circle->getRigidbody()->getEntity());
+        }
+
+        RaycastResult raycastTilemapCollider(TilemapCollider* tilemap, Ray ray) {
+
+            // Work in tiles, with the map from (0, 0) to its width and height. Distances along the ray stay the same.
+            int width = tilemap->getWidth();
+            int height = tilemap->getHeight();
+            if (width == 0 || height == 0 || tilemap->getRotation() != 0.0f) {return RaycastResult();}
+            vec2 tileSize = tilemap->getTileSize();
+            vec2 origin = (ray.origin - tilemap->getPosition()) / tileSize;
+            vec2 direction = ray.direction / tileSize;
+
+            // Find where the ray enters the map, or start from its origin if it is already inside.
+            vec2 half = vec2(width, height) * 0.5f;
+            float t = 0.0f;
+            vec2 normal = vec2(0.0f, 0.0f);
+            vec2 local = origin - half;
+            bool inside = fabsf(local.x) <= half.x && fabsf(local.y) <= half.y;
+            if (!inside && !raycastBox(local, direction, half, t, normal)) {return RaycastResult();}
+
+            // Walk the tiles along the ray until it reaches a solid one.
+            vec2 start = origin + direction * t;
+            int x = std::min(std::max((int) std::floor(start.x), 0), width - 1);
+            int y = std::min(std::max((int) std::floor(start.y), 0), height - 1);
+            if (inside && tilemap->isSolid(x, y)) {return RaycastResult();}
+
+            int xStep = direction.x > 0.0f ? 1 : -1;
+            int yStep = direction.y > 0.0f ? 1 : -1;
+            float xNext = direction.x == 0.0f ? FLT_MAX : (x + (xStep > 0 ? 1 : 0) - origin.x) / direction.x;
+            float yNext = direction.y == 0.0f ? FLT_MAX : (y + (yStep > 0 ? 1 : 0) - origin.y) / direction.y;
+            float xDelta = direction.x == 0.0f ? FLT_MAX : 1.0f / fabsf(direction.x);
+            float yDelta = direction.y == 0.0f ? FLT_MAX : 1.0f / fabsf(direction.y);
+
+            while (t <= ray.distance && x >= 0 && x < width && y >= 0 && y < height) {
+
+                if (tilemap->isSolid(x, y)) {
+                    vec2 point = ray.direction * t + ray.origin;
+                    return RaycastResult(point, normal, t, tilemap->getRigidbody()->getEntity());
+                }
+
+                if (xNext < yNext) {t = xNext; xNext += xDelta; x += xStep; normal = vec2((float) -xStep, 0.0f);}
+                else {t = yNext; yNext += yDelta; y += yStep; normal = vec2(0.0f, (float) -yStep);}
+
+            }
+
+            return RaycastResult();
 
         }
 
@@ -108,10 +275,18 @@ namespace Pancake {
         RaycastResult raycast(Rigidbody* rigidbody, Ray ray) {
 
             RaycastResult best;
-            for (Collider* collider : rigidbody->getColliders()) {
+            int n = rigidbody->getColliderCount();
+            for (int i = 0; i < n; i++) {
+                Collider* collider = rigidbody->getCollider(i);
                 RaycastResult current;
-                if (dynamic_cast<BoxCollider*>(collider) != nullptr) {current = raycastBoxCollider((BoxCollider*) collider, ray);}
-                if (dynamic_cast<CircleCollider*>(collider) != nullptr) {current = raycastCircleCollider((CircleCollider*) collider, ray);}
+                switch (collider->getShape()) {
+                    case BOX_COLLIDER: current = raycastBoxCollider((BoxCollider*) collider, ray); break;
+                    case CIRCLE_COLLIDER: current = raycastCircleCollider((CircleCollider*) collider, ray); break;
+                    case POLYGON_COLLIDER: current = raycastPolygonCollider((PolygonCollider*) collider, ray); break;
+                    case CAPSULE_COLLIDER: current = raycastCapsuleCollider((CapsuleCollider*) collider, ray); break;
+                    case TILEMAP_COLLIDER: current = raycastTilemapCollider((TilemapCollider*) collider, ray); break;
+                    default: break;
+                }
                 if (current.hit != nullptr && current.distance < best.distance) {best = current;}
             }
 
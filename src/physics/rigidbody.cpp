@@ -1,6 +1,7 @@
 #include <cmath>
 #include <limits>
 #include <iostream>
+#include "pancake/physics/bodies.hpp"
 #include "pancake/physics/rigidbody.hpp"
 #include "pancake/core/window.hpp"
 
@@ -30,6 +31,17 @@ namespace Pancake {
 
         this->sensor = false;
         this->fixedOrientation = false;
+        this->continuous = false;
+
+        this->layers = 1;
+        this->mask = ALL_LAYERS;
+
+        this->awake = true;
+        this->sleepingAllowed = true;
+        this->sleepTime = 0.0f;
+
+        this->bodies = nullptr;
+        this->body = -1;
 
     }
 
@@ -46,20 +58,26 @@ namespace Pancake {
         
         json j = this->Component::serialise();
 
+        glm::vec2 force = this->getForce();
         j.emplace("force", json::array());
-        j["force"].push_back(this->force.x);
-        j["force"].push_back(this->force.y);
+        j["force"].push_back(force.x);
+        j["force"].push_back(force.y);
         
+        glm::vec2 velocity = this->getVelocity();
         j.emplace("velocity", json::array());
-        j["velocity"].push_back(this->velocity.x);
-        j["velocity"].push_back(this->velocity.y);
+        j["velocity"].push_back(velocity.x);
+        j["velocity"].push_back(velocity.y);
         
-        j.emplace("torque", this->torque);
-        j.emplace("angularVelocity", this->angularVelocity);
+        j.emplace("torque", this->getTorque());
+        j.emplace("angularVelocity", this->getAngularVelocity());
         j.emplace("restitution", this->restitution);
         j.emplace("friction", this->friction);
         j.emplace("sensor", this->sensor);
         j.emplace("fixedOrientation", this->fixedOrientation);
+        j.emplace("sleepingAllowed", this->sleepingAllowed);
+        j.emplace("continuous", this->continuous);
+        j.emplace("layers", this->layers);
+        j.emplace("mask", this->mask);
 
         j.emplace("colliders", json::array());
         for (Collider* c : this->colliders) {
@@ -104,6 +122,10 @@ namespace Pancake {
         this->setFriction(j["friction"]);
         this->setSensor(j["sensor"]);
         this->setFixedOrientation(j["fixedOrientation"]);
+        if (j.contains("sleepingAllowed") && j["sleepingAllowed"].is_boolean()) {this->setSleepingAllowed(j["sleepingAllowed"]);}
+        if (j.contains("continuous") && j["continuous"].is_boolean()) {this->setContinuous(j["continuous"]);}
+        if (j.contains("layers") && j["layers"].is_number_unsigned()) {this->setLayers(j["layers"]);}
+        if (j.contains("mask") && j["mask"].is_number_unsigned()) {this->setMask(j["mask"]);}
 
         if (j.contains("colliders") && j["colliders"].is_array()) {
             for (auto element : j["colliders"]) {
@@ -133,12 +155,26 @@ namespace Pancake {
         return this->colliders;
     }
 
+    Collider* Rigidbody::getCollider(int index) {
+        return this->colliders[index];
+    }
+
+    int Rigidbody::getColliderCount() {
+        return this->colliders.size();
+    }
+
     std::unordered_set<std::string> Rigidbody::getForceGenerators() {
         return this->forceGenerators;
     }
 
+    glm::vec2 Rigidbody::getForce() {
+        if (this->bodies != nullptr) {return this->bodies->getForce(this->body);}
+        return this->force;
+    }
+
     glm::vec2 Rigidbody::getVelocity() {
         if (this->hasInfiniteMass()) {return glm::vec2(0.0f, 0.0f);}
+        if (this->bodies != nullptr) {return this->bodies->getVelocity(this->body);}
         return this->velocity;
     }
 
@@ -184,7 +220,7 @@ namespace Pancake {
 
     std::pair<glm::vec2, glm::vec2> Rigidbody::getBounds() {
 
-        if (!this->boundsDirty) {return this->bounds;}
+        if (!this->isBoundsDirty()) {return this->bounds;}
 
         glm::vec2 first = glm::vec2(0.0f, 0.0f);
         glm::vec2 second = glm::vec2(0.0f, 0.0f);
@@ -207,12 +243,20 @@ namespace Pancake {
         glm::vec2 position = this->getEntity()->getPosition();
         this->bounds = std::make_pair(position + first, position + second);
         this->boundsDirty = false;
+        this->lastPosition = position;
+        this->lastRotation = this->getEntity()->getRotation();
         return this->bounds;
 
     }
 
+    float Rigidbody::getTorque() {
+        if (this->bodies != nullptr) {return this->bodies->torque[this->body];}
+        return this->torque;
+    }
+
     float Rigidbody::getAngularVelocity() {
         if (this->hasInfiniteMass() || this->fixedOrientation) {return 0.0f;}
+        if (this->bodies != nullptr) {return this->bodies->angularVelocity[this->body];}
         return this->angularVelocity;
     }
 
@@ -284,6 +328,15 @@ namespace Pancake {
         return this->sensor;
     }
 
+    bool Rigidbody::isBoundsDirty() {
+
+        // The bounds are also dirty if the entity has moved or rotated since they were last computed.
+        Entity* entity = this->getEntity();
+        if (entity->getPosition() != this->lastPosition || entity->getRotation() != this->lastRotation) {this->boundsDirty = true;}
+        return this->boundsDirty;
+
+    }
+
     bool Rigidbody::hasForceGenerator(std::string type) {
         auto it = this->forceGenerators.find(type);
         return it != this->forceGenerators.end();
@@ -293,14 +346,49 @@ namespace Pancake {
         return this->fixedOrientation;
     }
 
+    bool Rigidbody::isContinuous() {
+        return this->continuous;
+    }
+
+    unsigned int Rigidbody::getLayers() {
+        return this->layers;
+    }
+
+    unsigned int Rigidbody::getMask() {
+        return this->mask;
+    }
+
+    bool Rigidbody::canCollide(Rigidbody* other) {
+        // Both rigidbodies have to want to collide with each other.
+        return (this->layers & other->mask) != 0 && (other->layers & this->mask) != 0;
+    }
+
+    bool Rigidbody::isAwake() {
+        return this->awake;
+    }
+
+    bool Rigidbody::isSleepingAllowed() {
+        return this->sleepingAllowed;
+    }
+
+    float Rigidbody::getSleepTime() {
+        return this->sleepTime;
+    }
+
+    int Rigidbody::getBody() {
+        return this->body;
+    }
+
     Rigidbody* Rigidbody::addCollider(Collider* collider) {
         if (collider != nullptr) {
             this->colliders.push_back(collider);
             collider->setRigidbody(this);
+            this->setAwake(true);
             this->centroidDirty = true;
             this->boundsDirty = true;
             this->massDirty = true;
             this->momentDirty = true;
+            if (this->bodies != nullptr) {this->bodies->setMassDirty(this->body);}
         }
         return this;
     }
@@ -319,10 +407,12 @@ namespace Pancake {
             if (this->colliders[i] == collider) {
                 this->colliders.erase(this->colliders.begin() + i);
                 delete collider;
+                this->setAwake(true);
                 this->centroidDirty = true;
                 this->boundsDirty = true;
                 this->massDirty = true;
                 this->momentDirty = true;
+                if (this->bodies != nullptr) {this->bodies->setMassDirty(this->body);}
                 break;
             }
         }
@@ -355,10 +445,12 @@ namespace Pancake {
             delete this->colliders[i];
         }
         this->colliders.clear();
+        this->setAwake(true);
         this->centroidDirty = true;
         this->boundsDirty = true;
         this->massDirty = true;
         this->momentDirty = true;
+        if (this->bodies != nullptr) {this->bodies->setMassDirty(this->body);}
         return this;
     }
 
@@ -433,7 +525,9 @@ namespace Pancake {
 
     Rigidbody* Rigidbody::setForce(glm::vec2 force) {
         if (this->hasInfiniteMass()) {return this;}
-        this->force = force;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->setForce(this->body, force);}
+        else {this->force = force;}
         return this;
     }
 
@@ -443,7 +537,9 @@ namespace Pancake {
 
     Rigidbody* Rigidbody::setVelocity(glm::vec2 velocity) {
         if (this->hasInfiniteMass()) {return this;}
-        this->velocity = velocity;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->setVelocity(this->body, velocity);}
+        else {this->velocity = velocity;}
         return this;
     }
 
@@ -452,18 +548,19 @@ namespace Pancake {
     }
 
     Rigidbody* Rigidbody::setTorque(float torque) {
-        this->torque = torque;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->torque[this->body] = torque;}
+        else {this->torque = torque;}
         return this;
     }
 
     Rigidbody* Rigidbody::setAngularVelocity(float angularVelocity) {
 
-        if (this->fixedOrientation) {
-            this->angularVelocity = 0.0f; 
-            return this;
-        }
+        if (this->fixedOrientation) {angularVelocity = 0.0f;}
+        else if (!this->awake) {this->setAwake(true);}
 
-        this->angularVelocity = angularVelocity;
+        if (this->bodies != nullptr) {this->bodies->angularVelocity[this->body] = angularVelocity;}
+        else {this->angularVelocity = angularVelocity;}
         return this;
     }
 
@@ -484,6 +581,22 @@ namespace Pancake {
 
     Rigidbody* Rigidbody::setFixedOrientation(bool orientation) {
         this->fixedOrientation = orientation;
+        if (this->bodies != nullptr) {this->bodies->setMassDirty(this->body);}
+        return this;
+    }
+
+    Rigidbody* Rigidbody::setContinuous(bool continuous) {
+        this->continuous = continuous;
+        return this;
+    }
+
+    Rigidbody* Rigidbody::setLayers(unsigned int layers) {
+        this->layers = layers;
+        return this;
+    }
+
+    Rigidbody* Rigidbody::setMask(unsigned int mask) {
+        this->mask = mask;
         return this;
     }
 
@@ -499,39 +612,96 @@ namespace Pancake {
 
     Rigidbody* Rigidbody::setMassDirty() {
         this->massDirty = true;
+        if (this->bodies != nullptr) {this->bodies->setMassDirty(this->body);}
         return this;
     }
 
     Rigidbody* Rigidbody::setMomentDirty() {
         this->momentDirty = true;
+        if (this->bodies != nullptr) {this->bodies->setMassDirty(this->body);}
         return this;
     }
 
+    Rigidbody* Rigidbody::setAwake(bool awake) {
+
+        this->awake = awake;
+        this->sleepTime = 0.0f;
+
+        // A sleeping rigidbody is at rest, and stays where it is until it is woken.
+        if (!awake) {
+            if (this->bodies != nullptr) {
+                this->bodies->setVelocity(this->body, glm::vec2(0.0f, 0.0f));
+                this->bodies->angularVelocity[this->body] = 0.0f;
+            } else {
+                this->velocity = glm::vec2(0.0f, 0.0f);
+                this->angularVelocity = 0.0f;
+            }
+            this->clearAccumulators();
+        }
+
+        return this;
+
+    }
+
+    Rigidbody* Rigidbody::setSleepingAllowed(bool allowed) {
+        this->sleepingAllowed = allowed;
+        if (!allowed && !this->awake) {this->setAwake(true);}
+        return this;
+    }
+
+    Rigidbody* Rigidbody::setBody(BodyStore* bodies, int body) {
+
+        // Take the state back from the store when leaving a world.
+        if (this->bodies != nullptr && bodies == nullptr) {
+            this->force = this->bodies->getForce(this->body);
+            this->velocity = this->bodies->getVelocity(this->body);
+            this->torque = this->bodies->torque[this->body];
+            this->angularVelocity = this->bodies->angularVelocity[this->body];
+        }
+
+        this->bodies = bodies;
+        this->body = body;
+        return this;
+
+    }
+
     void Rigidbody::clearAccumulators() {
-        this->force.x = 0;
-        this->force.y = 0;
-        this->torque = 0;
+        this->zeroForces();
+        this->zeroTorque();
     }
 
     void Rigidbody::physicsUpdate(float dt) {
-        
-        // Do not do a physics update if static.
-        if (this->hasInfiniteMass()) {return;}
+        this->integrateForces(dt);
+        this->integrateVelocity(dt);
+    }
+
+    void Rigidbody::integrateForces(float dt) {
+
+        // Do not do a physics update if static or asleep.
+        if (this->hasInfiniteMass() || !this->awake) {return;}
+
+        // Update the velocities from the accumulated forces.
+        this->setVelocity(this->getVelocity() + this->getForce() * (dt / this->getMass()));
+        if (!this->fixedOrientation) {this->setAngularVelocity(this->getAngularVelocity() + this->getTorque() * this->getInverseMomentOfInertia() * dt);}
+
+        // Clear the force and torque accumulators.
+        this->clearAccumulators();
 
-        // Required variables
-        glm::vec2 displacement = glm::vec2(0.0f, 0.0f);
-        float rotation = 0.0f;
+    }
+
+    void Rigidbody::integrateVelocity(float dt) {
+        
+        // Do not do a physics update if static or asleep.
+        if (this->hasInfiniteMass() || !this->awake) {return;}
 
         // Update linear
-        this->velocity += this->force * (dt / this->getMass());
-        displacement = this->velocity * dt;
+        glm::vec2 displacement = this->getVelocity() * dt;
         this->getEntity()->addPosition(displacement);
 
         // Update the rotation if allowed to.
         if (!this->fixedOrientation) {
 
-            this->angularVelocity += this->torque * (dt / this->getMass());
-            rotation = this->angularVelocity * dt;
+            float rotation = this->getAngularVelocity() * dt;
             this->getEntity()->addRotationAround(rotation, this->getCentroid());
 
             // Update all collider position offsets.
@@ -548,31 +718,27 @@ namespace Pancake {
             // Note: There is no need to update collider rotation offsets since they are updated in the entity.
         }
 
-        // Clear the force and torque accumulators.
-        this->clearAccumulators();
+    }
 
-        // Check if there has been a changed in the bounding box.
-        this->boundsDirty = (this->lastPosition != this->getEntity()->getPosition()) || 
-                            (this->lastRotation != this->getEntity()->getRotation()) ||
-                            (displacement != glm::vec2(0.0f, 0.0f)) || 
-                            (rotation != 0.0f) || 
-                            (this->boundsDirty);
-
-        // If the bounding box has changed we need to update the spatial hash grid.
-        if (this->boundsDirty) {
-            std::pair<glm::vec2, glm::vec2> bounds = this->getBounds();
-            Window::getScene()->getPhysics()->getGrid()->update(this, bounds.first, bounds.second);
-        }
-    
-        // Update last position and rotation
-        this->lastPosition = this->getEntity()->getPosition();
-        this->lastRotation = this->getEntity()->getRotation();
+    void Rigidbody::updateSleepTime(float dt, float linearTolerance, float angularTolerance) {
+
+        if (this->hasInfiniteMass() || !this->awake) {return;}
+
+        // Any noticeable movement restarts the timer.
+        glm::vec2 velocity = this->getVelocity();
+        float angularVelocity = this->getAngularVelocity();
+        bool moving = glm::dot(velocity, velocity) > linearTolerance * linearTolerance;
+        moving = moving || angularVelocity * angularVelocity > angularTolerance * angularTolerance;
+        if (!this->sleepingAllowed || moving) {this->sleepTime = 0.0f;}
+        else {this->sleepTime += dt;}
 
     }
 
     void Rigidbody::addVelocity(glm::vec2 velocity) {
         if (this->hasInfiniteMass()) {return;}
-        this->velocity += velocity;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->setVelocity(this->body, this->bodies->getVelocity(this->body) + velocity);}
+        else {this->velocity += velocity;}
     }
 
     void Rigidbody::addVelocity(float x, float y) {
@@ -581,12 +747,16 @@ namespace Pancake {
 
     void Rigidbody::addAngularVelocity(float angularVelocity) {
         if (this->hasInfiniteMass() || this->fixedOrientation) {return;}
-        this->angularVelocity += angularVelocity;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->angularVelocity[this->body] += angularVelocity;}
+        else {this->angularVelocity += angularVelocity;}
     }
 
     void Rigidbody::addForce(glm::vec2 force) {
         if (this->hasInfiniteMass()) {return;}
-        this->force += force;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->setForce(this->body, this->bodies->getForce(this->body) + force);}
+        else {this->force += force;}
     }
 
     void Rigidbody::addForce(float x, float y) {
@@ -594,16 +764,20 @@ namespace Pancake {
     }
 
     void Rigidbody::zeroForces() {
-        this->force = glm::vec2(0.0f, 0.0f);
+        if (this->bodies != nullptr) {this->bodies->setForce(this->body, glm::vec2(0.0f, 0.0f));}
+        else {this->force = glm::vec2(0.0f, 0.0f);}
     }
 
     void Rigidbody::addTorque(float torque) {
         if (this->hasInfiniteMass()) {return;}
-        this->torque += torque;
+        if (!this->awake) {this->setAwake(true);}
+        if (this->bodies != nullptr) {this->bodies->torque[this->body] += torque;}
+        else {this->torque += torque;}
     }
 
     void Rigidbody::zeroTorque() {
-        this->torque = 0.0f;
+        if (this->bodies != nullptr) {this->bodies->torque[this->body] = 0.0f;}
+        else {this->torque = 0.0f;}
     }
 
     bool Rigidbody::hasInfiniteMass() {
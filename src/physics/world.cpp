@@ -1,11 +1,15 @@
 #include <cmath>
+#include <chrono>
 #include <limits>
+#include <cstring>
+#include <cstdint>
 #include <algorithm>
+#include <iostream>
 #include <glm/glm.hpp>
 #include <glm/geometric.hpp>
-#include <glm/gtx/rotate_vector.hpp>
 
 #include "pancake/core/factory.hpp"
+#include "pancake/core/profiler.hpp"
 #include "pancake/physics/world.hpp"
 #include "pancake/graphics/debugdraw.hpp"
 
@@ -13,163 +17,74 @@ namespace Pancake {
 
     namespace {
 
-        class ImpulseResult {
-            
-            public:
-
-                glm::vec2 aPosition;
-                glm::vec2 bPosition;
-                glm::vec2 aVelocity;
-                glm::vec2 bVelocity;
-                float aAngularVelocity;
-                float bAngularVelocity;
-                float aAngularVelocityTotal;
-                float bAngularVelocityTotal;
-                float aAngularOrbitalSpeed;
-                float bAngularOrbitalSpeed;
-
-                ImpulseResult() {
-                    this->aPosition = glm::vec2(0.0f, 0.0f);
-                    this->bPosition = glm::vec2(0.0f, 0.0f);
-                    this->aVelocity = glm::vec2(0.0f, 0.0f);
-                    this->bVelocity = glm::vec2(0.0f, 0.0f);
-                    this->aAngularVelocity = 0.0f;
-                    this->bAngularVelocity = 0.0f;
-                    this->aAngularVelocityTotal = 0.0f;
-                    this->bAngularVelocityTotal = 0.0f;
-                    this->aAngularOrbitalSpeed = 0.0f;
-                    this->bAngularOrbitalSpeed = 0.0f;
-                }
+        const int IMPULSE_ITERATIONS = 6;
 
-                ImpulseResult operator*(float scalar) const {
-                    ImpulseResult result;
-                    result.aPosition = this->aPosition * scalar;
-                    result.bPosition = this->bPosition * scalar;
-                    result.aVelocity = this->aVelocity * scalar;
-                    result.bVelocity = this->bVelocity * scalar;
-                    result.aAngularVelocity = this->aAngularVelocity * scalar;
-                    result.bAngularVelocity = this->bAngularVelocity * scalar;
-                    result.aAngularVelocityTotal = this->aAngularVelocityTotal * scalar;
-                    result.bAngularVelocityTotal = this->bAngularVelocityTotal * scalar;
-                    result.aAngularOrbitalSpeed = this->aAngularOrbitalSpeed * scalar;
-                    result.bAngularOrbitalSpeed = this->bAngularOrbitalSpeed * scalar;
-                    return result;                    
-                }
+        // The fewest candidate pairs worth handing to a job of their own.
+        const int NARROWPHASE_BATCH = 64;
 
-                ImpulseResult& operator+=(const ImpulseResult& rhs) {
-                    this->aPosition += rhs.aPosition;
-                    this->bPosition += rhs.bPosition;
-                    this->aVelocity += rhs.aVelocity;
-                    this->bVelocity += rhs.bVelocity;
-                    this->aAngularVelocity += rhs.aAngularVelocity;
-                    this->bAngularVelocity += rhs.bAngularVelocity;
-                    this->aAngularVelocityTotal += rhs.aAngularVelocityTotal;
-                    this->bAngularVelocityTotal += rhs.bAngularVelocityTotal;
-                    this->aAngularOrbitalSpeed += rhs.aAngularOrbitalSpeed;
-                    this->bAngularOrbitalSpeed += rhs.bAngularOrbitalSpeed;
-                    return *this;
-                }
+        // The fewest arbiters of one colour worth handing to a job of their own.
+        const int SOLVER_BATCH = 128;
 
-        };
-        
-        const int IMPULSE_ITERATIONS = 6;
-        
-        inline glm::vec2 perp(glm::vec2 v) {
-            return glm::rotate(v, glm::half_pi<float>());
-        }
-
-        inline float proj(glm::vec2 a, glm::vec2 b) {
-            return glm::dot(a, b) / glm::length(b);
-        }
-
-        ImpulseResult applyImpulse(Rigidbody* a, Rigidbody* b, CollisionManifold m) {
-
-            // Check for infinite mass objects.
-            ImpulseResult result;
-            if (a->hasInfiniteMass() && b->hasInfiniteMass()) {return result;}
-
-            DebugDraw::drawBox(m.point, glm::vec2(0.1f, 0.1f), 0.0f, vec3(1.0f, 0.0f, 0.0f), 10);
-            DebugDraw::drawLine(m.point, m.point + m.normal * 0.3f, vec3(0.0f, 0.0f, 1.0f), 10);
-
-            float invMassA = a->getInverseMass();
-            float invMassB = b->getInverseMass();
-            float invMoiA = a->getInverseMomentOfInertia();
-            float invMoiB = b->getInverseMomentOfInertia();
-            float angVelA = a->getAngularVelocity();
-            float angVelB = b->getAngularVelocity();
-            float restitution = a->getRestitution() * b->getRestitution();
-            float friction = std::max(a->getFriction(), b->getFriction());
-            glm::vec2 tangent = perp(m.normal);
-            glm::vec2 rA = m.point - a->getCentroid();
-            glm::vec2 rB = m.point - b->getCentroid();
-            glm::vec2 vAB = b->getVelocity() + perp(rB) * angVelB - a->getVelocity() - perp(rA) * angVelA;
-            float rAproj = proj(rA, m.normal);
-            float rAreg = proj(rA, tangent);
-            float rBproj = proj(rB, m.normal);
-            float rBreg = proj(rB, tangent);
-            float vproj = proj(vAB, m.normal);
-            float vreg = proj(vAB, tangent);
-
-            // If both bodies are moving away from each other.
-            if (vproj >= 0.0f) {return result;}
-
-            // Calculate the impulse of the collision.
-            float impulse =  -((1 + restitution) * vproj) / (invMassA + invMassB + (invMoiA * rAreg * rAreg) + (invMoiB * rBreg * rBreg));
-
-            // Resolve the collision.
-            result.aVelocity -= m.normal * impulse * invMassA;
-            result.bVelocity += m.normal * impulse * invMassB;
-            result.aAngularVelocity += impulse * invMoiA * rAreg;
-            result.bAngularVelocity -= impulse * invMoiB * rBreg;
-            result.aAngularVelocityTotal += fabsf(impulse * invMoiA * rAreg);
-            result.bAngularVelocityTotal += fabsf(impulse * invMoiB * rBreg);
-            result.aAngularOrbitalSpeed += fabsf(impulse * invMoiA * rAreg * rAreg);
-            result.bAngularOrbitalSpeed += fabsf(impulse * invMoiB * rBreg * rBreg);
-
-            // Calculate friction.
-            if (friction > 0.0f) {
-
-                float max = fabsf(vreg) / (invMassA + invMassB + (invMoiA * rAproj * rAproj) + (invMoiB * rBproj * rBproj));
-                float sign = vreg < 0.0f ? -1.0f : 1.0f;
-                impulse = friction * fabsf(impulse);
-                impulse = std::min(impulse, max);
-                impulse *= sign;
-
-                result.aVelocity += tangent * impulse * invMassA;
-                result.bVelocity -= tangent * impulse * invMassB;
-                result.aAngularVelocity += impulse * invMoiA * rAproj;
-                result.bAngularVelocity -= impulse * invMoiB * rBproj;
-                result.aAngularVelocityTotal += fabsf(impulse * invMoiA * rAproj);
-                result.bAngularVelocityTotal += fabsf(impulse * invMoiB * rBproj);
+        // Arbiters that do not fit in the colours tracked per rigidbody are solved serially at the end.
+        const int MAX_COLOURS = 64;
 
-            }
+        // The fewest queries worth handing to a job of their own.
+        const int QUERY_BATCH = 32;
 
-            // Position correction.
-            if (!a->hasInfiniteMass() && !b->hasInfiniteMass()) {
-                const float slop = 0.01f;
-                const float percent = 0.4f;
-                glm::vec2 correction = std::max(m.depth - slop, 0.0f) / (invMassA + invMassB) * percent * m.normal;
-                result.aPosition -= correction * invMassA;
-                result.bPosition += correction * invMassB;
-            }
-            
-            if (b->hasInfiniteMass()) {result.aPosition -= m.depth * m.normal;}
-            if (a->hasInfiniteMass()) {result.bPosition += m.depth * m.normal;}
+        // The most impacts a continuous rigidbody can stop at in one step.
+        const int CONTINUOUS_SUBSTEPS = 4;
+
+        // Islands that stay slower than these for long enough are put to sleep.
+        const float SLEEP_LINEAR_TOLERANCE = 0.05f;
+        const float SLEEP_ANGULAR_TOLERANCE = 0.035f;
+        const float TIME_TO_SLEEP = 0.5f;
 
-            return result;
+        typedef std::chrono::steady_clock Clock;
+
+        double milliseconds(Clock::time_point start, Clock::time_point end) {
+            return std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        // Shapes can only be swept a finite distance. A batch with any ray that has no distance is rejected
+        // as a whole, leaving every ray without hits.
+        bool hasDistances(const std::vector<Ray>& rays, RaycastHits& result) {
+            for (const Ray& ray : rays) {
+                if (ray.distance < FLT_MAX) {continue;}
+                result.hits.clear();
+                result.starts.assign(rays.size() + 1, 0);
+                return false;
+            }
+            return true;
         }
 
     }
 
+    StepTimings::StepTimings() {
+        this->integrate = 0.0;
+        this->broadphase = 0.0;
+        this->narrowphase = 0.0;
+        this->solve = 0.0;
+        this->total = 0.0;
+    }
+
     World::World(float timeStep, glm::vec2 gravity) {
-        this->grid = new SpatialHashGrid<Rigidbody*>(4);
+        this->broadphase = new SpatialHashBroadphase();
+        this->jobs = new JobPool(1);
         this->timeStep = timeStep;
         this->time = 0.0f;
+        this->step = 0;
+        this->deterministic = false;
     }
 
     World::~World() {
+
+        // Rigidbodies can outlive the world, so they take their state back from the body store.
+        for (int i = this->bodies.size() - 1; i >= 0; i--) {this->bodies.remove(i);}
+
         for (ForceGenerator* force : this->forces) {delete force;}
-        delete this->grid;
+        delete this->broadphase;
+        delete this->jobs;
+
     }
 
     void World::update(float dt) {
@@ -182,128 +97,634 @@ namespace Pancake {
 
     void World::fixedUpdate() {
 
-        // Update velocities of all rigidbodies
+        PROFILE_ZONE("World::fixedUpdate");
+        Clock::time_point start = Clock::now();
+        Profiler::begin("Integrate forces");
+
+        // Update the forces, and the velocities of all rigidbodies from them. Positions are only moved
+        // once contacts have been resolved, so resting bodies do not sink under gravity every step.
+        this->registry.updateForces(this->timeStep);
+        this->bodies.updateMasses();
+        this->bodies.integrateForces(this->timeStep);
+        Clock::time_point integrated = Clock::now();
+        Profiler::end();
+        Profiler::begin("Broadphase");
+
+        // Bring the broadphase up to date with every rigidbody that has moved.
+        this->updateBroadphase();
+
+        // Find all pairs of rigidbodies whose bounds overlap.
+        this->candidates.clear();
+        this->broadphase->pairs(this->candidates);
+        this->active.clear();
+        this->step++;
+
+        // Drop the pairs that cannot collide, and order the rest by id so the same two bodies always
+        // produce the same arbiter and normals.
+        int m = 0;
+        for (const std::pair<Rigidbody*, Rigidbody*>& candidate : this->candidates) {
+
+            Rigidbody* rigidbody1 = candidate.first;
+            Rigidbody* rigidbody2 = candidate.second;
+            if (rigidbody1->getId() > rigidbody2->getId()) {std::swap(rigidbody1, rigidbody2);}
+
+            // Check if they have infinite mass.
+            if (rigidbody1->hasInfiniteMass() && rigidbody2->hasInfiniteMass()) {continue;}
+
+            // Pairs that are both asleep keep their contacts as they are, ready for when they are woken,
+            // and are still touching as far as the listeners are concerned.
+            if (!rigidbody1->isAwake() && !rigidbody2->isAwake()) {
+                std::pair<int, int> key = std::make_pair(rigidbody1->getId(), rigidbody2->getId());
+                auto it = this->arbiters.find(key);
+                if (it != this->arbiters.end()) {it->second.setStamp(this->step);}
+                auto touch = this->touching.find(key);
+                if (touch != this->touching.end()) {touch->second.stamp = this->step;}
+                continue;
+            }
+
+            this->candidates[m] = std::make_pair(rigidbody1, rigidbody2);
+            m++;
+
+        }
+
+        this->candidates.resize(m);
+
+        // The broadphase order depends on where the rigidbodies are in its cells, so a deterministic
+        // world works through the pairs by id instead.
+        if (this->deterministic) {
+            std::sort(this->candidates.begin(), this->candidates.end(), [](const std::pair<Rigidbody*, Rigidbody*>& x, const std::pair<Rigidbody*, Rigidbody*>& y) {
+                return std::make_pair(x.first->getId(), x.second->getId()) < std::make_pair(y.first->getId(), y.second->getId());
+            });
+        }
+
+        Clock::time_point paired = Clock::now();
+        Profiler::end();
+        Profiler::begin("Narrowphase");
+
+        // Split the candidates into contiguous batches and test them across the job pool. Each batch
+        // writes to its own buffer, so reading the buffers back in order gives the same contacts in
+        // the same order as testing every pair on one thread.
+        int batches = std::max(1, std::min(this->jobs->getThreadCount() * 4, (m + NARROWPHASE_BATCH - 1) / NARROWPHASE_BATCH));
+        if (this->narrowphase.size() < batches) {this->narrowphase.resize(batches);}
+
+        this->jobs->run(batches, [this, m, batches](int batch) {
+
+            NarrowphaseBuffer& buffer = this->narrowphase[batch];
+            buffer.contacts.clear();
+            buffer.ends.clear();
+            buffer.kinds.clear();
+            buffer.slots.clear();
+            buffer.circles.clear();
+            buffer.circleBoxes.clear();
+
+            // Pack the pairs of single circles and boxes, and test them several at a time.
+            int begin = (long long) m * batch / batches;
+            int end = (long long) m * (batch + 1) / batches;
+            for (int i = begin; i < end; i++) {this->pack(this->candidates[i].first, this->candidates[i].second, buffer);}
+
+            buffer.circleManifolds.resize(buffer.circles.size());
+            buffer.circleHits.resize(buffer.circles.size());
+            buffer.circleBoxManifolds.resize(buffer.circleBoxes.size());
+            buffer.circleBoxHits.resize(buffer.circleBoxes.size());
+            Collision::findCollisionFeatures(buffer.circles, buffer.circleManifolds.data(), buffer.circleHits.data());
+            Collision::findCollisionFeatures(buffer.circleBoxes, buffer.circleBoxManifolds.data(), buffer.circleBoxHits.data());
+
+            // Gather the contacts back in candidate order, testing the other pairs as they come.
+            for (int i = begin; i < end; i++) {
+
+                int slot = buffer.slots[i - begin];
+                switch (buffer.kinds[i - begin]) {
+                    case PAIR_CIRCLES: if (buffer.circleHits[slot]) {buffer.contacts.push_back(Contact(buffer.circleManifolds[slot], 0));} break;
+                    case PAIR_CIRCLE_BOX: if (buffer.circleBoxHits[slot]) {buffer.contacts.push_back(Contact(buffer.circleBoxManifolds[slot], 0));} break;
+                    default: this->collide(this->candidates[i].first, this->candidates[i].second, buffer.contacts); break;
+                }
+
+                buffer.ends.push_back(buffer.contacts.size());
+
+            }
+
+        });
+
+        // Report the collisions and update the arbiters in candidate order.
+        for (int batch = 0; batch < batches; batch++) {
+
+            NarrowphaseBuffer& buffer = this->narrowphase[batch];
+            int begin = (long long) m * batch / batches;
+            int start = 0;
+
+            for (int j = 0; j < buffer.ends.size(); j++) {
+
+                Rigidbody* rigidbody1 = this->candidates[begin + j].first;
+                Rigidbody* rigidbody2 = this->candidates[begin + j].second;
+                Contact* contacts = buffer.contacts.data() + start;
+                int count = buffer.ends[j] - start;
+                start = buffer.ends[j];
+
+                // If the pair is not colliding.
+                if (count == 0) {continue;}
+
+                // Queue the collision for the listeners, if either side has any.
+                if (!rigidbody1->getEntity()->getCollisionListeners().empty() || !rigidbody2->getEntity()->getCollisionListeners().empty()) {
+                    this->touch(rigidbody1, rigidbody2, contacts, count);
+                }
+
+                // Sensors report collisions but are not resolved.
+                if (rigidbody1->isSensor() || rigidbody2->isSensor()) {continue;}
+
+                // Find or create the arbiter for the pair, carrying over impulses from the previous step.
+                std::pair<int, int> key = std::make_pair(rigidbody1->getId(), rigidbody2->getId());
+                auto it = this->arbiters.find(key);
+                if (it == this->arbiters.end()) {it = this->arbiters.insert({key, Arbiter(rigidbody1, rigidbody2, &this->bodies)}).first;}
+
+                Arbiter* arbiter = &it->second;
+                arbiter->update(contacts, count);
+                arbiter->setStamp(this->step);
+
+            }
+
+        }
+
+        // Forget the arbiters of pairs that are no longer touching.
+        for (auto it = this->arbiters.begin(); it != this->arbiters.end();) {
+            if (it->second.getStamp() != this->step) {it = this->arbiters.erase(it);}
+            else {it++;}
+        }
+
+        Clock::time_point collided = Clock::now();
+        Profiler::end();
+        Profiler::begin("Solve");
+
+        // Wake every island touched by an awake rigidbody, and only solve the contacts of awake islands.
+        this->buildIslands();
+        for (auto& entry : this->arbiters) {
+            Arbiter& arbiter = entry.second;
+            Rigidbody* a = arbiter.getA();
+            Rigidbody* b = arbiter.getB();
+            if ((a->isAwake() && !a->hasInfiniteMass()) || (b->isAwake() && !b->hasInfiniteMass())) {this->active.push_back(&arbiter);}
+        }
+
+        // The map's order depends on its hashing and history, so a deterministic world solves by id.
+        if (this->deterministic) {
+            std::sort(this->active.begin(), this->active.end(), [](Arbiter* x, Arbiter* y) {
+                return std::make_pair(x->getA()->getId(), x->getB()->getId()) < std::make_pair(y->getA()->getId(), y->getB()->getId());
+            });
+        }
+
+        // Resolve collisions with sequential impulses, starting from the impulses of the last step. The
+        // prestep also fills the rigidbodies' cached centroids, so the coloured passes only read them.
+        for (Arbiter* arbiter : this->active) {arbiter->preStep();}
+        this->colourArbiters();
+        this->solve(&Arbiter::warmStart);
+        for (int k = 0; k < IMPULSE_ITERATIONS; k++) {
+            this->solve(&Arbiter::applyImpulse);
+        }
+
+        Clock::time_point solved = Clock::now();
+        Profiler::end();
+        Profiler::begin("Integrate positions");
+
+        // Update positions of all rigidbodies, then push apart any bodies that are still overlapping.
+        // Bodies at rest, which includes every static and sleeping one, do not need to be visited.
+        // Continuous rigidbodies go last, so they are swept against where everything else ends up.
+        // The broadphase still holds the bounds from before this move, so the sweeps widen their queries by
+        // the furthest any point of another rigidbody has moved.
         int n = this->rigidbodies.size();
+        float reach = 0.0f;
         for (int i = 0; i < n; i++) {
-            this->rigidbodies[i]->physicsUpdate(this->timeStep);
+            if (this->bodies.velocityX[i] == 0.0f && this->bodies.velocityY[i] == 0.0f && this->bodies.angularVelocity[i] == 0.0f) {continue;}
+            Rigidbody* rigidbody = this->rigidbodies[i];
+            if (rigidbody->isContinuous()) {continue;}
+            reach = std::max(reach, this->findReach(rigidbody));
+            rigidbody->integrateVelocity(this->timeStep);
         }
 
-        // Required data structures to store collision data.
-        std::unordered_set<std::pair<int, int>, IntPairHash> colliding;
-        std::vector<std::pair<Rigidbody*, Rigidbody*>> collisions;
-        std::vector<std::vector<CollisionManifold>> manifolds;
+        for (int i = 0; i < n; i++) {
+            if (this->bodies.velocityX[i] == 0.0f && this->bodies.velocityY[i] == 0.0f && this->bodies.angularVelocity[i] == 0.0f) {continue;}
+            if (!this->rigidbodies[i]->isContinuous()) {continue;}
+            this->advance(this->rigidbodies[i], reach);
+        }
 
-        for (const std::vector<Rigidbody*>& bodies : *this->grid) {
-            
-            for (int i = 0; i < bodies.size(); i++) {
+        Clock::time_point moved = Clock::now();
+        Profiler::end();
+        Profiler::begin("Correct positions");
 
-                for (int j = i + 1; j < bodies.size(); j++) {
+        this->solve(&Arbiter::correctPositions);
 
-                    // Get the next pairing
-                    Rigidbody* rigidbody1 = bodies[i];
-                    Rigidbody* rigidbody2 = bodies[j];
+        // Put islands that have come to rest to sleep.
+        this->sleepIslands();
+        Clock::time_point corrected = Clock::now();
+        Profiler::end();
 
-                    // Check if this pairing has already been collided.
-                    int smaller = std::min(rigidbody1->getId(), rigidbody2->getId());
-                    int larger = std::max(rigidbody1->getId(), rigidbody2->getId());
-                    std::pair<int, int> ids = std::make_pair(smaller, larger);
-                    auto it = colliding.find(ids);
-                    if (it != colliding.end()) {continue;}
+        // Tell the listeners about the step's collisions.
+        Profiler::begin("Listeners");
+        this->dispatch();
+        Profiler::end();
 
-                    // Check if they have infinite mass.
-                    if (rigidbody1->hasInfiniteMass() && rigidbody2->hasInfiniteMass()) {continue;}
+        this->timings.integrate = milliseconds(start, integrated) + milliseconds(solved, moved);
+        this->timings.broadphase = milliseconds(integrated, paired);
+        this->timings.narrowphase = milliseconds(paired, collided);
+        this->timings.solve = milliseconds(collided, solved) + milliseconds(moved, corrected);
+        this->timings.total = milliseconds(start, Clock::now());
 
-                    // Get the colliders of each body.
-                    std::vector<Collider*> colliders1 = rigidbody1->getColliders();
-                    std::vector<Collider*> colliders2 = rigidbody2->getColliders();
+    }
 
-                    // If either has no colliders then we cant collide.
-                    if (colliders1.size() == 0 || colliders2.size() == 0) {continue;}
+    void World::touch(Rigidbody* a, Rigidbody* b, const Contact* contacts, int count) {
 
-                    // Test collision of each pairing of colliders.
-                    std::vector<CollisionManifold> results;
-                    for (int k = 0; k < colliders1.size(); k++) {
-                        for (int l = 0; l < colliders2.size(); l++) {
-                            
-                            Collider* collider1 = colliders1[k];
-                            Collider* collider2 = colliders2[l];
+        // Listeners hear about the deepest contact, once for the pair.
+        int deepest = 0;
+        for (int k = 1; k < count; k++) {
+            if (contacts[k].manifold.depth > contacts[deepest].manifold.depth) {deepest = k;}
+        }
 
-                            std::vector<CollisionManifold> features = Collision::findCollisionFeatures(collider1, collider2);
-                            for (CollisionManifold feature : features) {results.push_back(feature);}
+        std::pair<int, int> key = std::make_pair(a->getId(), b->getId());
+        auto it = this->touching.find(key);
+        CollisionEventKind kind = it == this->touching.end() ? COLLISION_BEGIN : COLLISION_STAY;
+        if (it == this->touching.end()) {it = this->touching.insert({key, {a, b, this->step}}).first;}
+        it->second.stamp = this->step;
 
-                        }
-                    }
+        this->events.push_back({a, b, contacts[deepest].manifold, kind});
 
-                    // If there is a new collision that we havent found yet.
-                    if (results.size() > 0) {
-                        
-                        // Add the ID pair so we dont collide them again.
-                        colliding.insert(ids);
+    }
 
-                        // Update the listeners
-                        for (CollisionManifold manifold : results) {
+    void World::dispatch() {
 
-                            for (Component* component : rigidbody1->getEntity()->getComponents()) {
-                                CollisionListener* listener = dynamic_cast<CollisionListener*>(component);
-                                if (listener != nullptr) {listener->collision(rigidbody2->getEntity(), manifold);}
-                            }
+        // Pairs that were not seen touching this step have come apart. They are reported in id order,
+        // so the order does not depend on the map.
+        int ends = this->events.size();
+        for (auto it = this->touching.begin(); it != this->touching.end();) {
+            if (it->second.stamp == this->step) {it++; continue;}
+            this->events.push_back({it->second.a, it->second.b, CollisionManifold(), COLLISION_END});
+            it = this->touching.erase(it);
+        }
+        std::sort(this->events.begin() + ends, this->events.end(), [](const CollisionEvent& x, const CollisionEvent& y) {
+            return std::make_pair(x.a->getId(), x.b->getId()) < std::make_pair(y.a->getId(), y.b->getId());
+        });
+
+        for (CollisionEvent& event : this->events) {
+
+            // A listener may have taken either rigidbody out of the world already.
+            if (!this->has(event.a) || !this->has(event.b)) {continue;}
+
+            Entity* entity1 = event.a->getEntity();
+            Entity* entity2 = event.b->getEntity();
+            CollisionManifold flipped = event.manifold.flip();
+            const std::vector<CollisionListener*>& listeners1 = entity1->getCollisionListeners();
+            const std::vector<CollisionListener*>& listeners2 = entity2->getCollisionListeners();
+
+            // Listeners hear about the collision every step it lasts, including the one it begins on.
+            for (int i = 0; i < listeners1.size(); i++) {
+                if (event.kind == COLLISION_END) {listeners1[i]->endCollision(entity2); continue;}
+                if (event.kind == COLLISION_BEGIN) {listeners1[i]->beginCollision(entity2, event.manifold);}
+                listeners1[i]->collision(entity2, event.manifold);
+            }
 
-                            CollisionManifold flipped = manifold.flip();
-                            for (Component* component : rigidbody2->getEntity()->getComponents()) {
-                                CollisionListener* listener = dynamic_cast<CollisionListener*>(component);
-                                if (listener != nullptr) {listener->collision(rigidbody1->getEntity(), flipped);}
-                            }
+            for (int i = 0; i < listeners2.size(); i++) {
+                if (event.kind == COLLISION_END) {listeners2[i]->endCollision(entity1); continue;}
+                if (event.kind == COLLISION_BEGIN) {listeners2[i]->beginCollision(entity1, flipped);}
+                listeners2[i]->collision(entity1, flipped);
+            }
 
-                        }
+        }
 
-                        // Add the bodies to the impulse list if they are not sensors.
-                        if (!rigidbody1->isSensor() && !rigidbody2->isSensor()) {
-                            collisions.push_back(std::make_pair(rigidbody1, rigidbody2));
-                            manifolds.push_back(results);
-                        }
+        this->events.clear();
 
-                    }
+    }
+
+    void World::colourArbiters() {
+
+        // Greedily give every arbiter the first colour not yet used by either of its dynamic rigidbodies,
+        // so no two arbiters of the same colour touch the same velocities. Static rigidbodies are never
+        // written to by the solver, so they can be shared within a colour.
+        int n = this->rigidbodies.size();
+        this->colourMasks.assign(n, 0);
+        for (std::vector<Arbiter*>& colour : this->colours) {colour.clear();}
+        this->colours.resize(MAX_COLOURS + 1);
+
+        // Without workers there is nothing to gain, and solving in contact order converges faster. A
+        // deterministic world always colours, so it gives the same result for any number of threads.
+        if (this->jobs->getThreadCount() == 1 && !this->deterministic) {
+            this->colours[MAX_COLOURS] = this->active;
+            return;
+        }
+
+        for (Arbiter* arbiter : this->active) {
+
+            Rigidbody* a = arbiter->getA();
+            Rigidbody* b = arbiter->getB();
+            unsigned long long used = 0;
+            if (!a->hasInfiniteMass()) {used |= this->colourMasks[a->getBody()];}
+            if (!b->hasInfiniteMass()) {used |= this->colourMasks[b->getBody()];}
+
+            int colour = 0;
+            while (colour < MAX_COLOURS && (used & (1ULL << colour)) != 0) {colour++;}
+            this->colours[colour].push_back(arbiter);
+            if (colour == MAX_COLOURS) {continue;}
+
+            if (!a->hasInfiniteMass()) {this->colourMasks[a->getBody()] |= 1ULL << colour;}
+            if (!b->hasInfiniteMass()) {this->colourMasks[b->getBody()] |= 1ULL << colour;}
+
+        }
+
+    }
+
+    void World::solve(void (Arbiter::*method)()) {
+
+        // Colours are solved one after the other, the arbiters within a colour are independent and split
+        // across the job pool. The result does not depend on how a colour is split, or on the thread count.
+        for (int c = 0; c < MAX_COLOURS; c++) {
+
+            std::vector<Arbiter*>& colour = this->colours[c];
+            int m = colour.size();
+            if (m == 0) {break;}
+
+            int batches = std::max(1, std::min(this->jobs->getThreadCount() * 4, m / SOLVER_BATCH));
+            this->jobs->run(batches, [&colour, m, batches, method](int batch) {
+                int end = (long long) m * (batch + 1) / batches;
+                for (int i = (long long) m * batch / batches; i < end; i++) {(colour[i]->*method)();}
+            });
+
+        }
+
+        for (Arbiter* arbiter : this->colours[MAX_COLOURS]) {(arbiter->*method)();}
+
+    }
+
+    void World::pack(Rigidbody* a, Rigidbody* b, NarrowphaseBuffer& buffer) {
+
+        // Only rigidbodies with a single collider each are packed, anything else is tested pairing by pairing.
+        if (a->getColliderCount() == 1 && b->getColliderCount() == 1) {
+
+            Collider* collider1 = a->getCollider(0);
+            Collider* collider2 = b->getCollider(0);
+            ColliderShape shape1 = collider1->getShape();
+            ColliderShape shape2 = collider2->getShape();
+
+            if (shape1 == CIRCLE_COLLIDER && shape2 == CIRCLE_COLLIDER) {
+                buffer.kinds.push_back(PAIR_CIRCLES);
+                buffer.slots.push_back(buffer.circles.size());
+                buffer.circles.add((CircleCollider*) collider1, (CircleCollider*) collider2);
+                return;
+            }
+
+            if (shape1 == CIRCLE_COLLIDER && shape2 == BOX_COLLIDER) {
+                buffer.kinds.push_back(PAIR_CIRCLE_BOX);
+                buffer.slots.push_back(buffer.circleBoxes.size());
+                buffer.circleBoxes.add((CircleCollider*) collider1, (BoxCollider*) collider2, false);
+                return;
+            }
+
+            if (shape1 == BOX_COLLIDER && shape2 == CIRCLE_COLLIDER) {
+                buffer.kinds.push_back(PAIR_CIRCLE_BOX);
+                buffer.slots.push_back(buffer.circleBoxes.size());
+                buffer.circleBoxes.add((CircleCollider*) collider2, (BoxCollider*) collider1, true);
+                return;
+            }
+
+        }
+
+        buffer.kinds.push_back(PAIR_COLLIDERS);
+        buffer.slots.push_back(-1);
+
+    }
+
+    void World::collide(Rigidbody* a, Rigidbody* b, std::vector<Contact>& result) {
+
+        // Test collision of each pairing of colliders, tagging every point with the pairing it came from.
+        int n1 = a->getColliderCount();
+        int n2 = b->getColliderCount();
+        for (int k = 0; k < n1; k++) {
+            for (int l = 0; l < n2; l++) {
+
+                Collider* c1 = a->getCollider(k);
+                Collider* c2 = b->getCollider(l);
+                int pairing = k * n2 + l;
+
+                // A tilemap is tested box by box, against only the boxes near the other collider. Each box
+                // counts as a pairing of its own.
+                bool tilemap1 = c1->getShape() == TILEMAP_COLLIDER;
+                bool tilemap2 = c2->getShape() == TILEMAP_COLLIDER;
+                if (tilemap1 || tilemap2) {
+
+                    if (tilemap1 && tilemap2) {continue;}
+                    TilemapCollider* tilemap = (TilemapCollider*) (tilemap1 ? c1 : c2);
+                    Collider* other = tilemap1 ? c2 : c1;
+                    std::pair<glm::vec2, glm::vec2> bounds = other->getLocalBounds();
+                    glm::vec2 position = other->getPosition();
+
+                    tilemap->query(position + bounds.first, position + bounds.second, [&](BoxCollider* box, int index) {
+                        CollisionManifold features[Collision::MAX_MANIFOLDS];
+                        int count = tilemap1 ? Collision::findCollisionFeatures(box, other, features) : Collision::findCollisionFeatures(other, box, features);
+                        for (int i = 0; i < count; i++) {result.push_back(Contact(features[i], pairing + n1 * n2 * (index + 1)));}
+                    });
+                    continue;
 
                 }
 
+                CollisionManifold features[Collision::MAX_MANIFOLDS];
+                int count = Collision::findCollisionFeatures(c1, c2, features);
+                for (int i = 0; i < count; i++) {result.push_back(Contact(features[i], pairing));}
+
             }
+        }
+
+    }
+
+    float World::findReach(Rigidbody* rigidbody) {
 
+        // A rotation moves a point by at most the chord it sweeps, which is never more than the arc
+        // or the diameter. The bounds are still clean here, so reading them does not rebuild them.
+        float reach = glm::length(rigidbody->getVelocity()) * this->timeStep;
+        float turn = std::abs(rigidbody->getAngularVelocity()) * this->timeStep;
+        if (turn == 0.0f) {return reach;}
+
+        std::pair<glm::vec2, glm::vec2> bounds = rigidbody->getBounds();
+        glm::vec2 pivot = rigidbody->getEntity()->getPosition();
+        glm::vec2 corner = glm::max(glm::abs(bounds.first - pivot), glm::abs(bounds.second - pivot));
+        return reach + std::min(turn, 2.0f) * glm::length(corner);
+
+    }
+
+    void World::advance(Rigidbody* rigidbody, float reach) {
+
+        // Sensors pass through everything anyway.
+        if (rigidbody->isSensor()) {
+            rigidbody->integrateVelocity(this->timeStep);
+            return;
         }
-        
-        // Update the forces
-        this->registry.updateForces(this->timeStep);
 
-        // Resolve collision via iterative impulse resolution.
-        for (int k = 0; k < IMPULSE_ITERATIONS; k++) {
-            int m = collisions.size();
-            for (int i = 0; i < m; i++) {
+        // Move the rigidbody through the step in pieces, stopping at the first impact along each piece
+        // and exchanging an impulse with whatever it hit. Everything else is treated as still.
+        float remaining = this->timeStep;
+        for (int s = 0; s < CONTINUOUS_SUBSTEPS && remaining > 0.0f; s++) {
 
-                Rigidbody* r1 = collisions[i].first;
-                Rigidbody* r2 = collisions[i].second;
-                ImpulseResult sum;
+            glm::vec2 velocity = rigidbody->getVelocity();
+            glm::vec2 displacement = velocity * remaining;
 
-                float depthTotal = 0.0f;
-                for (int j = 0; j < manifolds[i].size(); j++) {depthTotal += manifolds[i][j].depth;}
-                for (int j = 0; j < manifolds[i].size(); j++) {sum += applyImpulse(r1, r2, manifolds[i][j]) * (manifolds[i][j].depth / depthTotal);}
+            // Look for anything in the bounds swept along the displacement, grown by how far the others moved.
+            std::pair<glm::vec2, glm::vec2> bounds = rigidbody->getBounds();
+            glm::vec2 min = glm::min(bounds.first, bounds.first + displacement) - reach;
+            glm::vec2 max = glm::max(bounds.second, bounds.second + displacement) + reach;
+            this->sweep.clear();
+            this->broadphase->query(min, max, this->sweep);
+
+            TimeOfImpact first;
+            Rigidbody* hit = nullptr;
+            for (Rigidbody* other : this->sweep) {
+
+                if (other == rigidbody || other->isSensor() || !rigidbody->canCollide(other)) {continue;}
+
+                int n1 = rigidbody->getColliderCount();
+                int n2 = other->getColliderCount();
+                for (int k = 0; k < n1; k++) {
+                    for (int l = 0; l < n2; l++) {
+
+                        Collider* c1 = rigidbody->getCollider(k);
+                        Collider* c2 = other->getCollider(l);
+                        if (c1->getShape() == TILEMAP_COLLIDER) {continue;}
+
+                        // Sweep against each of a tilemap's boxes near the path.
+                        if (c2->getShape() == TILEMAP_COLLIDER) {
+                            std::pair<glm::vec2, glm::vec2> local = c1->getLocalBounds();
+                            glm::vec2 position = c1->getPosition();
+                            glm::vec2 from = position + local.first;
+                            glm::vec2 to = position + local.second;
+                            ((TilemapCollider*) c2)->query(glm::min(from, from + displacement), glm::max(to, to + displacement), [&](BoxCollider* box, int index) {
+                                TimeOfImpact impact = Continuous::findTimeOfImpact(c1, displacement, box);
+                                if (impact.hit && impact.time < first.time) {first = impact; hit = other;}
+                            });
+                            continue;
+                        }
 
-                r1->getEntity()->addPosition(sum.aPosition);
-                r2->getEntity()->addPosition(sum.bPosition);
-                r1->addVelocity(sum.aVelocity);
-                r2->addVelocity(sum.bVelocity);
-                r1->addAngularVelocity(sum.aAngularVelocity);
-                r2->addAngularVelocity(sum.bAngularVelocity);
+                        TimeOfImpact impact = Continuous::findTimeOfImpact(c1, displacement, c2);
+                        if (impact.hit && impact.time < first.time) {first = impact; hit = other;}
 
-                if (sum.aAngularVelocityTotal > 0.0f && glm::dot(sum.aVelocity, sum.aVelocity) > 0.0f) {r1->addVelocity(((sum.aAngularVelocityTotal - fabsf(sum.aAngularVelocity)) / sum.aAngularVelocityTotal) * sum.aAngularOrbitalSpeed * glm::normalize(sum.aVelocity));}
-                if (sum.bAngularVelocityTotal > 0.0f && glm::dot(sum.bVelocity, sum.bVelocity) > 0.0f) {r2->addVelocity(((sum.bAngularVelocityTotal - fabsf(sum.bAngularVelocity)) / sum.bAngularVelocityTotal) * sum.bAngularOrbitalSpeed * glm::normalize(sum.bVelocity));}
+                    }
+                }
 
             }
-            
+
+            rigidbody->integrateVelocity(remaining * first.time);
+            if (hit == nullptr) {return;}
+            remaining *= 1.0f - first.time;
+
+            // Bounce off the impact the same way the solver would, with the combined restitution, pushing
+            // the other rigidbody away by the opposite impulse.
+            float inverseMass = rigidbody->getInverseMass() + hit->getInverseMass();
+            float approach = glm::dot(velocity - hit->getVelocity(), first.normal);
+            if (approach > 0.0f && inverseMass > 0.0f) {
+                float restitution = rigidbody->getRestitution() * hit->getRestitution();
+                glm::vec2 impulse = (1.0f + restitution) * approach / inverseMass * first.normal;
+                rigidbody->setVelocity(velocity - impulse * rigidbody->getInverseMass());
+                if (!hit->hasInfiniteMass()) {
+                    hit->setVelocity(hit->getVelocity() + impulse * hit->getInverseMass());
+                    hit->setAwake(true);
+                }
+            }
+
+        }
+
+    }
+
+    void World::updateBroadphase() {
+
+        // Only rigidbodies whose bounds have changed need to be updated. This includes bodies moved
+        // by the solver or directly through their entity, as well as static bodies. The broadphase
+        // itself only re-bins a rigidbody once its bounds leave the region it is registered in.
+        for (Rigidbody* rigidbody : this->rigidbodies) {
+
+            // Sleeping rigidbodies do not move on their own, so one that has moved was teleported. Static
+            // rigidbodies are only awake on steps they move, so they wake anything resting on them.
+            bool moved = rigidbody->isBoundsDirty();
+            if (rigidbody->hasInfiniteMass()) {rigidbody->setAwake(moved);}
+            else if (moved && !rigidbody->isAwake()) {rigidbody->setAwake(true);}
+
+            if (!moved) {continue;}
+            std::pair<glm::vec2, glm::vec2> bounds = rigidbody->getBounds();
+            this->broadphase->update(rigidbody, bounds.first, bounds.second);
+
+        }
+
+    }
+
+    int World::findIsland(int rigidbody) {
+        while (this->islands[rigidbody] != rigidbody) {
+            this->islands[rigidbody] = this->islands[this->islands[rigidbody]];
+            rigidbody = this->islands[rigidbody];
+        }
+        return rigidbody;
+    }
+
+    void World::buildIslands() {
+
+        // Every rigidbody starts in its own island.
+        int n = this->rigidbodies.size();
+        this->islands.resize(n);
+        for (int i = 0; i < n; i++) {this->islands[i] = i;}
+
+        // Merge the islands of touching dynamic rigidbodies. Static rigidbodies do not join islands,
+        // otherwise everything resting on the ground would be one island.
+        for (auto& entry : this->arbiters) {
+            Rigidbody* a = entry.second.getA();
+            Rigidbody* b = entry.second.getB();
+            if (a->hasInfiniteMass() || b->hasInfiniteMass()) {continue;}
+            int i = this->findIsland(a->getBody());
+            int j = this->findIsland(b->getBody());
+            if (i != j) {this->islands[i] = j;}
+        }
+
+        // An island is awake if any of its rigidbodies is, or it touches a static rigidbody that moved.
+        std::vector<bool>& awake = this->islandsAwake;
+        awake.assign(n, false);
+        for (int i = 0; i < n; i++) {
+            Rigidbody* rigidbody = this->rigidbodies[i];
+            if (!rigidbody->hasInfiniteMass() && rigidbody->isAwake()) {awake[this->findIsland(i)] = true;}
+        }
+
+        for (auto& entry : this->arbiters) {
+            Rigidbody* a = entry.second.getA();
+            Rigidbody* b = entry.second.getB();
+            if (a->hasInfiniteMass() && a->isAwake() && !b->hasInfiniteMass()) {awake[this->findIsland(b->getBody())] = true;}
+            if (b->hasInfiniteMass() && b->isAwake() && !a->hasInfiniteMass()) {awake[this->findIsland(a->getBody())] = true;}
+        }
+
+        for (int i = 0; i < n; i++) {
+            Rigidbody* rigidbody = this->rigidbodies[i];
+            if (rigidbody->hasInfiniteMass() || rigidbody->isAwake()) {continue;}
+            if (awake[this->findIsland(i)]) {rigidbody->setAwake(true);}
+        }
+
+    }
+
+    void World::sleepIslands() {
+
+        // An island can sleep once every rigidbody in it has been resting for long enough.
+        int n = this->rigidbodies.size();
+        this->islandSleepTimes.assign(n, std::numeric_limits<float>::max());
+        for (int i = 0; i < n; i++) {
+            Rigidbody* rigidbody = this->rigidbodies[i];
+            if (rigidbody->hasInfiniteMass() || !rigidbody->isAwake()) {continue;}
+            rigidbody->updateSleepTime(this->timeStep, SLEEP_LINEAR_TOLERANCE, SLEEP_ANGULAR_TOLERANCE);
+            int island = this->findIsland(i);
+            this->islandSleepTimes[island] = std::min(this->islandSleepTimes[island], rigidbody->getSleepTime());
+        }
+
+        for (int i = 0; i < n; i++) {
+            Rigidbody* rigidbody = this->rigidbodies[i];
+            if (rigidbody->hasInfiniteMass() || !rigidbody->isAwake()) {continue;}
+            if (this->islandSleepTimes[this->findIsland(i)] < TIME_TO_SLEEP) {continue;}
+
+            // Settle the broadphase now, so the last correction is not mistaken for a teleport next step.
+            rigidbody->setAwake(false);
+            std::pair<glm::vec2, glm::vec2> bounds = rigidbody->getBounds();
+            this->broadphase->update(rigidbody, bounds.first, bounds.second);
         }
 
     }
 
     void World::render() {
 
+        PROFILE_ZONE("World::render");
+
         int n = this->rigidbodies.size();
         for (int i = 0; i < n; i++) {
 
@@ -313,6 +734,15 @@ namespace Pancake {
 
         }
 
+        // Draw the contact points and normals found in the last step.
+        for (auto& entry : this->arbiters) {
+            for (const Contact& contact : entry.second.getContacts()) {
+                const CollisionManifold& m = contact.manifold;
+                DebugDraw::drawBox(m.point, glm::vec2(0.1f, 0.1f), 0.0f, vec3(1.0f, 0.0f, 0.0f), 1);
+                DebugDraw::drawLine(m.point, m.point + m.normal * 0.3f, vec3(0.0f, 0.0f, 1.0f), 1);
+            }
+        }
+
     }
 
     void World::add(Rigidbody* rigidbody) {
@@ -320,14 +750,18 @@ namespace Pancake {
         // Insert the rigidbody in the index and the vector.
         this->rigidbodies.push_back(rigidbody);
         this->rigidbodiesIndex.insert(rigidbody);
+        this->bodies.add(rigidbody);
 
-        // Add the rigidbody to the spatial hash grid.
+        // Add the rigidbody to the broadphase.
         std::pair<glm::vec2, glm::vec2> bounds = rigidbody->getBounds();
-        this->grid->add(rigidbody, bounds.first, bounds.second);
+        this->broadphase->add(rigidbody, bounds.first, bounds.second);
 
-        // Apply all required force generators to the rigidbody.
+        // Apply all required force generators to the rigidbody, in name order so the forces are always
+        // summed in the same order.
         std::unordered_set<std::string> generators = rigidbody->getForceGenerators();
-        for (const std::string& type : generators) {
+        std::vector<std::string> types(generators.begin(), generators.end());
+        std::sort(types.begin(), types.end());
+        for (const std::string& type : types) {
             this->addForceRegistration(type, rigidbody);
         }
 
@@ -340,8 +774,24 @@ namespace Pancake {
 
     void World::remove(Rigidbody* rigidbody) {
 
-        // Remove the rigidbody from the index if it is in it.
+        // Remove the rigidbody from the index and the broadphase if it is in it.
         this->rigidbodiesIndex.erase(rigidbody);
+        this->broadphase->remove(rigidbody);
+
+        // Forget any contacts the rigidbody was part of.
+        for (auto it = this->arbiters.begin(); it != this->arbiters.end();) {
+            if (it->second.getA() == rigidbody || it->second.getB() == rigidbody) {it = this->arbiters.erase(it);}
+            else {it++;}
+        }
+
+        // Whatever the rigidbody was touching is told it has gone, once the pairs are forgotten.
+        std::vector<Rigidbody*> others;
+        for (auto it = this->touching.begin(); it != this->touching.end();) {
+            const Touch& touch = it->second;
+            if (touch.a != rigidbody && touch.b != rigidbody) {it++; continue;}
+            others.push_back(touch.a == rigidbody ? touch.b : touch.a);
+            it = this->touching.erase(it);
+        }
 
         // Remove the rigidbody from the rigidbody vector.
         int n = this->rigidbodies.size();
@@ -355,28 +805,245 @@ namespace Pancake {
                 }
 
                 this->rigidbodies.erase(this->rigidbodies.begin() + i);
-                return;
+                this->bodies.remove(i);
+                break;
 
             }
         
         }
 
+        for (Rigidbody* other : others) {
+            const std::vector<CollisionListener*>& listeners = other->getEntity()->getCollisionListeners();
+            for (int i = 0; i < listeners.size(); i++) {listeners[i]->endCollision(rigidbody->getEntity());}
+        }
+
+    }
+
+    void World::cast(const Ray& ray, const RoundedPolygon* shape, RaycastMode mode, std::vector<Rigidbody*>& nearby, std::vector<RaycastResult>& result) {
+
+        // Keep each hit the mode asks for, and track how far along the ray is still worth searching.
+        int first = result.size();
+        float limit = ray.distance;
+        auto keep = [&](const RaycastResult& hit) {
+            if (hit.hit == nullptr || hit.distance > limit) {return;}
+            if (mode == RAYCAST_ALL) {result.push_back(hit); return;}
+            if ((int) result.size() == first) {result.push_back(hit);}
+            else {result.back() = hit;}
+            limit = mode == RAYCAST_ANY ? -1.0f : hit.distance;
+        };
+
+        // Rays only test the rigidbodies whose bounds they pass through.
+        if (shape == nullptr) {
+            this->broadphase->raycast(ray.origin, ray.direction, ray.distance, [&](Rigidbody* rigidbody) -> float {
+                if ((rigidbody->getLayers() & ray.mask) == 0) {return limit;}
+                keep(Raycast::raycast(rigidbody, ray));
+                return limit;
+            });
+        }
+
+        // Shapes are swept against every rigidbody near their path.
+        else if (ray.distance < FLT_MAX) {
+
+            RoundedPolygon start = shape->translate(ray.origin);
+            glm::vec2 displacement = ray.direction * ray.distance;
+            glm::vec2 min = start.vertices[0];
+            glm::vec2 max = start.vertices[0];
+            for (int i = 1; i < start.count; i++) {
+                min = glm::min(min, start.vertices[i]);
+                max = glm::max(max, start.vertices[i]);
+            }
+            min = glm::min(min, min + displacement) - start.radius;
+            max = glm::max(max, max + displacement) + start.radius;
+
+            nearby.clear();
+            this->broadphase->query(min, max, nearby);
+            for (Rigidbody* rigidbody : nearby) {
+
+                if ((rigidbody->getLayers() & ray.mask) == 0) {continue;}
+
+                TimeOfImpact impact;
+                int n = rigidbody->getColliderCount();
+                for (int i = 0; i < n; i++) {
+
+                    Collider* collider = rigidbody->getCollider(i);
+                    if (collider->getShape() == TILEMAP_COLLIDER) {
+                        ((TilemapCollider*) collider)->query(min, max, [&](BoxCollider* box, int index) {
+                            TimeOfImpact current = Continuous::findTimeOfImpact(start, displacement, box);
+                            if (current.hit && current.time < impact.time) {impact = current;}
+                        });
+                        continue;
+                    }
+
+                    TimeOfImpact current = Continuous::findTimeOfImpact(start, displacement, collider);
+                    if (current.hit && current.time < impact.time) {impact = current;}
+
+                }
+
+                if (!impact.hit) {continue;}
+                float distance = impact.time * ray.distance;
+                keep(RaycastResult(ray.origin + ray.direction * distance, -impact.normal, distance, rigidbody->getEntity()));
+                if (limit < 0.0f) {break;}
+
+            }
+
+        }
+
+        if (mode == RAYCAST_ALL) {
+            std::sort(result.begin() + first, result.end(), [](const RaycastResult& a, const RaycastResult& b) {return a.distance < b.distance;});
+        }
+
+    }
+
+    void World::cast(const std::vector<Ray>& rays, const RoundedPolygon* shape, RaycastMode mode, RaycastHits& result) {
+
+        // Anything the broadphase or the tilemaps build lazily is built here, so the jobs below only read it.
+        // Tilemaps changed since the last step would otherwise be swept with their old boxes.
+        this->broadphase->prepare();
+        for (Rigidbody* rigidbody : this->rigidbodies) {
+            int count = rigidbody->getColliderCount();
+            for (int i = 0; i < count; i++) {
+                Collider* collider = rigidbody->getCollider(i);
+                if (collider->getShape() == TILEMAP_COLLIDER) {((TilemapCollider*) collider)->prepare();}
+            }
+        }
+
+        int n = rays.size();
+        int batches = std::max(1, std::min(this->jobs->getThreadCount() * 4, n / QUERY_BATCH));
+        if ((int) this->queries.size() < batches) {this->queries.resize(batches);}
+        result.starts.assign(n + 1, 0);
+
+        this->jobs->run(batches, [this, &rays, &result, shape, mode, n, batches](int batch) {
+            QueryBuffer& buffer = this->queries[batch];
+            buffer.hits.clear();
+            int end = (long long) n * (batch + 1) / batches;
+            for (int i = (long long) n * batch / batches; i < end; i++) {
+                int before = buffer.hits.size();
+                this->cast(rays[i], shape, mode, buffer.nearby, buffer.hits);
+                result.starts[i + 1] = buffer.hits.size() - before;
+            }
+        });
+
+        // The batches cover the rays in order, so their hits can be joined one after another.
+        result.hits.clear();
+        for (int i = 0; i < n; i++) {result.starts[i + 1] += result.starts[i];}
+        for (int batch = 0; batch < batches; batch++) {
+            result.hits.insert(result.hits.end(), this->queries[batch].hits.begin(), this->queries[batch].hits.end());
+        }
+
     }
 
     RaycastResult World::raycast(Ray ray) {
+        std::vector<RaycastResult> hits;
+        std::vector<Rigidbody*> nearby;
+        this->cast(ray, nullptr, RAYCAST_CLOSEST, nearby, hits);
+        return hits.empty() ? RaycastResult() : hits[0];
+    }
+
+    void World::raycast(const std::vector<Ray>& rays, RaycastMode mode, RaycastHits& result) {
+        this->cast(rays, nullptr, mode, result);
+    }
 
-        RaycastResult best;
+    void World::circlecast(const std::vector<Ray>& rays, float radius, RaycastMode mode, RaycastHits& result) {
+        if (!hasDistances(rays, result)) {
+            std::cout << "ERROR::WORLD::CIRCLECAST::RAY_WITHOUT_DISTANCE\n";
+            return;
+        }
+        RoundedPolygon shape(glm::vec2(0.0f, 0.0f), radius);
+        this->cast(rays, &shape, mode, result);
+    }
+
+    void World::boxcast(const std::vector<Ray>& rays, glm::vec2 size, float rotation, RaycastMode mode, RaycastHits& result) {
+        if (!hasDistances(rays, result)) {
+            std::cout << "ERROR::WORLD::BOXCAST::RAY_WITHOUT_DISTANCE\n";
+            return;
+        }
+        RoundedPolygon shape(glm::vec2(0.0f, 0.0f), size, rotation);
+        this->cast(rays, &shape, mode, result);
+    }
+
+    std::vector<Rigidbody*> World::query(glm::vec2 min, glm::vec2 max) {
+        std::vector<Rigidbody*> result;
+        this->broadphase->query(min, max, result);
+        return result;
+    }
+
+    std::vector<Rigidbody*> World::query(glm::vec2 min, glm::vec2 max, unsigned int mask) {
+        std::vector<Rigidbody*> result;
+        this->broadphase->query(min, max, result);
+        result.erase(std::remove_if(result.begin(), result.end(), [mask](Rigidbody* rigidbody) {return (rigidbody->getLayers() & mask) == 0;}), result.end());
+        return result;
+    }
+
+
+    Broadphase* World::getBroadphase() {
+        return this->broadphase;
+    }
+
+    void World::setBroadphase(Broadphase* broadphase) {
+
+        if (broadphase == nullptr || broadphase == this->broadphase) {return;}
+        delete this->broadphase;
+        this->broadphase = broadphase;
+
+        // Register all existing rigidbodies with the new broadphase.
+        this->broadphase->clear();
         for (Rigidbody* rigidbody : this->rigidbodies) {
-            RaycastResult current = Raycast::raycast(rigidbody, ray);
-            if (current.hit != nullptr && current.distance < best.distance) {best = current;}
+            std::pair<glm::vec2, glm::vec2> bounds = rigidbody->getBounds();
+            this->broadphase->add(rigidbody, bounds.first, bounds.second);
         }
 
-        return best;
     }
 
+    int World::getThreadCount() {
+        return this->jobs->getThreadCount();
+    }
+
+    void World::setThreadCount(int threads) {
+        threads = std::max(threads, 1);
+        if (threads == this->jobs->getThreadCount()) {return;}
+        delete this->jobs;
+        this->jobs = new JobPool(threads);
+    }
+
+    StepTimings World::getTimings() {
+        return this->timings;
+    }
+
+    bool World::isDeterministic() {
+        return this->deterministic;
+    }
+
+    void World::setDeterministic(bool deterministic) {
+        this->deterministic = deterministic;
+    }
+
+    unsigned long long World::getChecksum() {
+
+        // FNV-1a over the bits of every rigidbody's position and velocities, in the order they were added.
+        unsigned long long hash = 14695981039346656037ULL;
+        auto mix = [&hash](float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 4; i++) {
+                hash ^= (bits >> (i * 8)) & 0xFF;
+                hash *= 1099511628211ULL;
+            }
+        };
+
+        for (Rigidbody* rigidbody : this->rigidbodies) {
+            Entity* entity = rigidbody->getEntity();
+            glm::vec2 position = entity->getPosition();
+            glm::vec2 velocity = rigidbody->getVelocity();
+            mix(position.x);
+            mix(position.y);
+            mix(entity->getRotation());
+            mix(velocity.x);
+            mix(velocity.y);
+            mix(rigidbody->getAngularVelocity());
+        }
+
+        return hash;
 
-    SpatialHashGrid<Rigidbody*>* World::getGrid() {
-        return this->grid;
     }
 
     ForceGenerator* World::getForceGenerator(std::string type) {